@@ -12,32 +12,129 @@ Licence:  See bottom of header file.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h> // Interlocked*() atomics and QueryPerformanceCounter()
+#endif
 
 #define APG_C_MAX_COMMAND_HIST 4
+#define APG_C_MAX_AUTOCOMPLETE_CANDIDATES 16 // candidates listed in the output when autocompletion is ambiguous
+#define APG_C_MAX_EXEC_DEPTH 8               // how deeply scripts may `exec` other scripts
+#define APG_C_PROFILE_N_BUCKETS 32           // histogram buckets of function call times. bucket b counts calls under 2^b microseconds
 
 typedef struct apg_c_func_t {
-  char str[APG_C_STR_MAX];
+  const char* str;
   // NOTE: the string arg is allowed to be NULL, meaning no argument given to function
   bool ( *func_ptr )( const char* );
+  // timings of calls from the console, for the `profile` command
+  uint32_t n_calls;
+  double total_s, min_s, max_s;
+  uint32_t histogram[APG_C_PROFILE_N_BUCKETS];
 } apg_c_func_t;
 
-static apg_c_var_t _c_vars[APG_C_VARS_MAX];
+/* names are interned in a string arena of linked blocks, so pointers to them stay valid as more are added */
+typedef struct _c_arena_block_t {
+  struct _c_arena_block_t* next;
+  size_t used, capacity;
+  char bytes[];
+} _c_arena_block_t;
+
+#define _C_ARENA_BLOCK_SIZE 4096
+static _c_arena_block_t* _c_arena;
+
+// variables are allocated in blocks of APG_C_VARS_MAX, so pointers returned by apg_c_get_var() stay valid as more are registered
+static apg_c_var_t** _c_var_blocks;
+static uint32_t _n_c_var_blocks;
 static uint32_t _n_c_vars;
 
-static apg_c_func_t _c_funcs[APG_C_FUNCS_MAX];
-static uint32_t _n_c_funcs;
+static apg_c_func_t* _c_funcs;
+static uint32_t _n_c_funcs, _c_funcs_capacity;
+
+/* output lines are variable-length records in one text ring buffer, found through a ring of line offsets.
+the oldest lines are dropped when either ring runs out of space. */
+typedef struct _c_output_line_t {
+  uint32_t offset, len;
+} _c_output_line_t;
+
+static char* _c_output_text;                                  // each line is stored nul-terminated
+static uint32_t _c_output_text_capacity, _c_output_text_head; // head is where the next line is written
+static _c_output_line_t* _c_output_lines;
+static uint32_t _c_output_lines_capacity, _c_output_lines_oldest;
+static int c_n_output_lines;
+
+/* apg_c_print_mt() queue. a bounded lock-free multi-producer queue (D. Vyukov's design) of fixed-size slots, drained into the output by the thread that
+owns the console. each slot's sequence number says whether it is free for a producer or written and ready for the consumer.
+sequence numbers are stored relative to the slot index so a zeroed queue is ready to use without initialisation. */
+#ifndef APG_C_PRINT_QUEUE_LEN
+#define APG_C_PRINT_QUEUE_LEN 256 // must be a power of two
+#endif
+#ifdef _MSC_VER
+typedef volatile LONG _c_atomic_u32_t;
+#else
+typedef uint32_t _c_atomic_u32_t;
+#endif
+
+typedef struct _c_print_slot_t {
+  _c_atomic_u32_t sequence;
+  char str[APG_C_STR_MAX];
+} _c_print_slot_t;
 
-static char c_output_lines[APG_C_OUTPUT_LINES_MAX][APG_C_STR_MAX];
-static int c_output_lines_oldest = -1, c_output_lines_newest = -1, c_n_output_lines = 0;
+static _c_print_slot_t _c_print_queue[APG_C_PRINT_QUEUE_LEN];
+static _c_atomic_u32_t _c_print_queue_tail;   // next position producers claim
+static uint32_t _c_print_queue_head;          // next position the consumer reads. only used by the console's thread
+static _c_atomic_u32_t _c_n_prints_dropped;   // total lines dropped because the queue was full
+static uint32_t _c_n_prints_dropped_reported; // how many of those the console has printed a warning about
 static char _c_user_entered_text[APG_C_STR_MAX];
 static char _c_command_history[APG_C_MAX_COMMAND_HIST][APG_C_STR_MAX];
 static int _c_latest_command_in_history = -1;
 
-static const int _c_n_built_in_commands            = 5;
-static char _c_built_in_commands[5][APG_C_STR_MAX] = { "help", "clear", "list_vars", "list_funcs" };
+static const int _c_n_built_in_commands            = 6;
+static char _c_built_in_commands[6][APG_C_STR_MAX] = { "help", "clear", "list_vars", "list_funcs", "exec", "profile" };
+static int _c_exec_depth; // number of `exec` scripts currently running
+static uint64_t _c_var_change_count;
+static double ( *_c_timer_func )( void ); // set by apg_c_set_timer_func(). NULL uses _default_time_s()
+
+/* builtins, functions, and variables are indexed by name in an open-addressing hash table with linear probing.
+all names are also inserted into one radix trie for autocompletion. */
+typedef enum _c_name_kind_t { _C_NAME_NONE = 0, _C_NAME_BUILTIN, _C_NAME_FUNC, _C_NAME_VAR } _c_name_kind_t;
+typedef struct _c_name_ref_t {
+  uint32_t hash;
+  uint32_t idx; // index into the builtin, function, or variable array
+  uint8_t kind; // _c_name_kind_t. _C_NAME_NONE marks an empty hash table slot
+} _c_name_ref_t;
+
+static _c_name_ref_t* _c_name_table;
+static uint32_t _c_name_table_size; // power of two, kept at least twice the number of names so probe sequences stay short
+static uint32_t _c_n_names;
+
+/* radix trie node. the edge label into the node is a substring of one of the stored names, so no string copies are needed.
+children are kept sorted by their first label byte so names enumerate alphabetically. */
+typedef struct _c_trie_node_t {
+  int label_idx;                   // index of the name the edge label is part of
+  int end_idx;                     // index of the name that ends at this node
+  int first_child, next_sibling;   // -1 for none
+  int n_names;                     // number of distinct names in this node's subtree
+  uint8_t label_kind, end_kind;    // _c_name_kind_t. end_kind is _C_NAME_NONE if no name ends here
+  uint8_t label_offset, label_len; // edge label byte range within the name
+} _c_trie_node_t;
+
+static _c_trie_node_t* _c_trie_nodes; // [0] is the root
+static uint32_t _c_n_trie_nodes, _c_trie_nodes_capacity;
+static bool _c_builtin_names_added;
 
 static bool _c_redraw_required;
 
+// dirty tracking for apg_c_draw_to_image_mem(). the image itself is the cache of rendered lines, so only changed rows need redrawing.
+static bool _c_redraw_all = true; // everything needs redrawing, eg after the output is cleared
+static bool _c_redraw_prompt;     // the user-entered text changed
+static int _c_n_lines_to_scroll;  // lines printed since the last draw. existing lines are scrolled up by this many rows
+static struct {
+  uint8_t* img_ptr;
+  int w, h, n_channels;
+  uint8_t background_colour[4];
+  int n_output_lines;
+} _c_last_draw; // what was drawn into last time. if any of this changes the whole image is redrawn
+
 /* because string.h doesn't always have strnlen() */
 static int apg_c_strnlen( const char* str, int maxlen ) {
   int i = 0;
@@ -63,6 +160,100 @@ static void apg_c_strncat( char* dst, const char* src, const int dest_max_len, c
   strncat( dst, src, n - 1 );                                                    // strncat manual guarantees null termination.
 }
 
+static uint32_t _atomic_load_acquire( _c_atomic_u32_t* ptr ) {
+#ifdef _MSC_VER
+  return (uint32_t)InterlockedOr( ptr, 0 );
+#else
+  return __atomic_load_n( ptr, __ATOMIC_ACQUIRE );
+#endif
+}
+
+static void _atomic_store_release( _c_atomic_u32_t* ptr, uint32_t val ) {
+#ifdef _MSC_VER
+  InterlockedExchange( ptr, (LONG)val );
+#else
+  __atomic_store_n( ptr, val, __ATOMIC_RELEASE );
+#endif
+}
+
+// RETURNS true if *ptr was expected, and is now desired
+static bool _atomic_cas( _c_atomic_u32_t* ptr, uint32_t expected, uint32_t desired ) {
+#ifdef _MSC_VER
+  return (uint32_t)InterlockedCompareExchange( ptr, (LONG)desired, (LONG)expected ) == expected;
+#else
+  return __atomic_compare_exchange_n( ptr, &expected, desired, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED );
+#endif
+}
+
+static void _atomic_increment( _c_atomic_u32_t* ptr ) {
+#ifdef _MSC_VER
+  InterlockedIncrement( ptr );
+#else
+  __atomic_fetch_add( ptr, 1, __ATOMIC_RELAXED );
+#endif
+}
+
+// grows a heap array to hold at least n_needed elements, doubling its capacity.
+// RETURNS the array, which may have moved, or NULL on allocation failure, in which case the original array is untouched.
+static void* _reserve( void* array, uint32_t* capacity, uint32_t n_needed, size_t element_sz ) {
+  if ( n_needed <= *capacity ) { return array; }
+  uint32_t new_capacity = *capacity > 0 ? *capacity : 16;
+  while ( new_capacity < n_needed ) { new_capacity *= 2; }
+  void* new_array = realloc( array, (size_t)new_capacity * element_sz );
+  if ( !new_array ) { return NULL; }
+  *capacity = new_capacity;
+  return new_array;
+}
+
+// RETURNS a nul-terminated copy of the first len bytes of str that lives until apg_c_free(), or NULL on allocation failure
+static const char* _intern_str( const char* str, size_t len ) {
+  if ( !_c_arena || _c_arena->capacity - _c_arena->used < len + 1 ) {
+    size_t capacity         = len + 1 > _C_ARENA_BLOCK_SIZE ? len + 1 : _C_ARENA_BLOCK_SIZE;
+    _c_arena_block_t* block = malloc( sizeof( _c_arena_block_t ) + capacity );
+    if ( !block ) { return NULL; }
+    block->next     = _c_arena;
+    block->used     = 0;
+    block->capacity = capacity;
+    _c_arena        = block;
+  }
+  char* copy = &_c_arena->bytes[_c_arena->used];
+  memcpy( copy, str, len );
+  copy[len] = '\0';
+  _c_arena->used += len + 1;
+  return copy;
+}
+
+static apg_c_var_t* _var_at( uint32_t idx ) { return &_c_var_blocks[idx / APG_C_VARS_MAX][idx % APG_C_VARS_MAX]; }
+
+// RETURNS false if there was no space for another variable and allocating a new block failed
+static bool _vars_reserve_one( void ) {
+  if ( _n_c_vars < _n_c_var_blocks * APG_C_VARS_MAX ) { return true; }
+  apg_c_var_t** blocks = realloc( _c_var_blocks, ( _n_c_var_blocks + 1 ) * sizeof( apg_c_var_t* ) );
+  if ( !blocks ) { return false; }
+  _c_var_blocks                  = blocks;
+  _c_var_blocks[_n_c_var_blocks] = malloc( APG_C_VARS_MAX * sizeof( apg_c_var_t ) );
+  if ( !_c_var_blocks[_n_c_var_blocks] ) { return false; }
+  _n_c_var_blocks++;
+  return true;
+}
+
+// RETURNS the text of the output line i lines back from the newest (0)
+static const char* _output_line( int i ) {
+  assert( i >= 0 && i < c_n_output_lines );
+  uint32_t line_idx = ( _c_output_lines_oldest + c_n_output_lines - 1 - i ) % _c_output_lines_capacity;
+  return &_c_output_text[_c_output_lines[line_idx].offset];
+}
+
+static void _drop_oldest_output_line( void ) {
+  _c_output_lines_oldest = ( _c_output_lines_oldest + 1 ) % _c_output_lines_capacity;
+  c_n_output_lines--;
+}
+
+static void _prompt_changed( void ) {
+  _c_redraw_prompt   = true;
+  _c_redraw_required = true;
+}
+
 static void _apg_c_command_hist_append( const char* _c_user_entered_text ) {
   assert( _c_user_entered_text );
 
@@ -78,7 +269,84 @@ static void _help() {
 
 static void _list_c_vars() {
   apg_c_print( "=====c_vars=====" );
-  for ( uint32_t i = 0; i < _n_c_vars; i++ ) { apg_c_print( _c_vars[i].str ); }
+  for ( uint32_t i = 0; i < _n_c_vars; i++ ) { apg_c_print( _var_at( i )->str ); }
+}
+
+// RETURNS seconds from a monotonic clock, if the platform has one
+static double _default_time_s( void ) {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  if ( 0 == frequency.QuadPart ) { QueryPerformanceFrequency( &frequency ); }
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter( &counter );
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+#elif defined( CLOCK_MONOTONIC )
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+  return (double)clock() / CLOCKS_PER_SEC; // processor time - only a rough stand-in
+#endif
+}
+
+static double _time_s( void ) { return _c_timer_func ? _c_timer_func() : _default_time_s(); }
+
+// calls a registered function, timing it for the `profile` command
+static bool _call_func( int func_idx, const char* arg_str ) {
+  double start_s     = _time_s();
+  bool result        = _c_funcs[func_idx].func_ptr( arg_str );
+  double elapsed_s   = _time_s() - start_s;
+  apg_c_func_t* func = &_c_funcs[func_idx]; // the callback may have registered more functions and moved the array
+
+  if ( 0 == func->n_calls || elapsed_s < func->min_s ) { func->min_s = elapsed_s; }
+  if ( 0 == func->n_calls || elapsed_s > func->max_s ) { func->max_s = elapsed_s; }
+  func->total_s += elapsed_s;
+  func->n_calls++;
+  int bucket = 0;
+  for ( double us = elapsed_s * 1e6; us >= 1.0 && bucket < APG_C_PROFILE_N_BUCKETS - 1; us *= 0.5 ) { bucket++; }
+  func->histogram[bucket]++;
+  return result;
+}
+
+// RETURNS an upper bound of the 99th percentile call time of a function, to the histogram's resolution
+static double _func_p99_s( const apg_c_func_t* func ) {
+  uint32_t n_below = 0, target = func->n_calls - func->n_calls / 100; // calls that must be at or under the result
+  for ( int bucket = 0; bucket < APG_C_PROFILE_N_BUCKETS; bucket++ ) {
+    n_below += func->histogram[bucket];
+    if ( n_below >= target ) {
+      double bound_s = (double)( 1u << bucket ) * 1e-6;
+      return bound_s < func->max_s ? bound_s : func->max_s;
+    }
+  }
+  return func->max_s;
+}
+
+static int _compare_funcs_by_total_time( const void* a, const void* b ) {
+  double total_a = _c_funcs[*(const uint32_t*)a].total_s, total_b = _c_funcs[*(const uint32_t*)b].total_s;
+  return total_a < total_b ? 1 : total_a > total_b ? -1 : 0;
+}
+
+// prints a table of timings of functions called from the console, slowest in total first
+static void _profile() {
+  char tmp[APG_C_STR_MAX];
+  uint32_t* order = malloc( ( _n_c_funcs + 1 ) * sizeof( uint32_t ) );
+  if ( !order ) { return; }
+  uint32_t n_called = 0;
+  for ( uint32_t i = 0; i < _n_c_funcs; i++ ) {
+    if ( _c_funcs[i].n_calls > 0 ) { order[n_called++] = i; }
+  }
+  qsort( order, n_called, sizeof( uint32_t ), _compare_funcs_by_total_time );
+
+  apg_c_print( "=====profile (ms)=====" );
+  snprintf( tmp, APG_C_STR_MAX, "%-24s %7s %10s %9s %9s %9s %9s", "function", "calls", "total", "mean", "min", "max", "p99" );
+  apg_c_print( tmp );
+  for ( uint32_t i = 0; i < n_called; i++ ) {
+    const apg_c_func_t* func = &_c_funcs[order[i]];
+    snprintf( tmp, APG_C_STR_MAX, "%-24.24s %7u %10.3f %9.3f %9.3f %9.3f %9.3f", func->str, func->n_calls, func->total_s * 1e3,
+      func->total_s * 1e3 / func->n_calls, func->min_s * 1e3, func->max_s * 1e3, _func_p99_s( func ) * 1e3 );
+    apg_c_print( tmp );
+  }
+  free( order );
 }
 
 static void _list_c_funcs() {
@@ -86,53 +354,318 @@ static void _list_c_funcs() {
   for ( uint32_t i = 0; i < _n_c_funcs; i++ ) { apg_c_print( _c_funcs[i].str ); }
 }
 
-// returns index or -1 if did not find
-// NOTE(Anton) could replace with a hash table
-static int _console_find_var( const char* str ) {
-  assert( str );
+// FNV-1a hash of a nul-terminated string
+static uint32_t _hash_str( const char* str ) {
+  uint32_t hash = 2166136261u;
+  for ( ; *str; str++ ) { hash = ( hash ^ (uint8_t)*str ) * 16777619u; }
+  return hash;
+}
+
+static const char* _name_str( int kind, int idx ) {
+  switch ( kind ) {
+  case _C_NAME_BUILTIN: return _c_built_in_commands[idx];
+  case _C_NAME_FUNC: return _c_funcs[idx].str;
+  case _C_NAME_VAR: return _var_at( idx )->str;
+  default: return "";
+  } // endswitch
+}
 
-  for ( uint32_t i = 0; i < _n_c_vars; i++ ) {
-    if ( strncmp( str, _c_vars[i].str, APG_C_STR_MAX ) == 0 ) { return i; }
+static const char* _trie_label( const _c_trie_node_t* node ) { return &_name_str( node->label_kind, node->label_idx )[node->label_offset]; }
+
+// nodes must already be reserved, so pointers into the node array stay valid while inserting
+static int _trie_new_node( int label_kind, int label_idx, int label_offset, int label_len ) {
+  assert( _c_n_trie_nodes < _c_trie_nodes_capacity );
+  int idx             = _c_n_trie_nodes++;
+  _c_trie_node_t* node = &_c_trie_nodes[idx];
+  memset( node, 0, sizeof( _c_trie_node_t ) );
+  node->label_kind   = (uint8_t)label_kind;
+  node->label_idx    = label_idx;
+  node->label_offset = (uint8_t)label_offset;
+  node->label_len    = (uint8_t)label_len;
+  node->first_child = node->next_sibling = -1;
+  return idx;
+}
+
+// RETURNS false on allocation failure
+static bool _trie_insert( int kind, int idx ) {
+  const char* str = _name_str( kind, idx );
+  const int len   = apg_c_strnlen( str, APG_C_STR_MAX );
+  int path[APG_C_STR_MAX + 1]; // nodes from the root down, for updating name counts
+  int path_len = 0;
+  int pos      = 0;
+
+  // inserting adds at most a leaf and a split node, plus the root the first time
+  _c_trie_node_t* nodes = _reserve( _c_trie_nodes, &_c_trie_nodes_capacity, _c_n_trie_nodes + 3, sizeof( _c_trie_node_t ) );
+  if ( !nodes ) { return false; }
+  _c_trie_nodes = nodes;
+  if ( 0 == _c_n_trie_nodes ) { _trie_new_node( _C_NAME_NONE, 0, 0, 0 ); }
+  int node        = 0;
+  path[path_len++] = node;
+  while ( pos < len ) {
+    // find the child starting with the next byte, or where a new one would go
+    int* link = &_c_trie_nodes[node].first_child;
+    while ( *link >= 0 && (uint8_t)_trie_label( &_c_trie_nodes[*link] )[0] < (uint8_t)str[pos] ) { link = &_c_trie_nodes[*link].next_sibling; }
+    if ( *link < 0 || _trie_label( &_c_trie_nodes[*link] )[0] != str[pos] ) {
+      int leaf                         = _trie_new_node( kind, idx, pos, len - pos );
+      _c_trie_nodes[leaf].next_sibling = *link;
+      *link                            = leaf;
+      node                             = leaf;
+      path[path_len++]                 = node;
+      break;
+    }
+    int child         = *link;
+    const char* label = _trie_label( &_c_trie_nodes[child] );
+    int n_common      = 1;
+    while ( n_common < _c_trie_nodes[child].label_len && pos + n_common < len && label[n_common] == str[pos + n_common] ) { n_common++; }
+    if ( n_common < _c_trie_nodes[child].label_len ) { // split the edge where the new name diverges
+      _c_trie_node_t* old             = &_c_trie_nodes[child];
+      int mid                         = _trie_new_node( old->label_kind, old->label_idx, old->label_offset, n_common );
+      _c_trie_nodes[mid].first_child  = child;
+      _c_trie_nodes[mid].next_sibling = old->next_sibling;
+      _c_trie_nodes[mid].n_names      = old->n_names;
+      old->next_sibling               = -1;
+      old->label_offset               = (uint8_t)( old->label_offset + n_common );
+      old->label_len                  = (uint8_t)( old->label_len - n_common );
+      *link                           = mid;
+      child                           = mid;
+    }
+    node             = child;
+    path[path_len++] = node;
+    pos += n_common;
   }
-  return -1;
+
+  if ( _c_trie_nodes[node].end_kind != _C_NAME_NONE ) { return true; } // same name already registered in another namespace
+  _c_trie_nodes[node].end_kind = (uint8_t)kind;
+  _c_trie_nodes[node].end_idx  = idx;
+  for ( int i = 0; i < path_len; i++ ) { _c_trie_nodes[path[i]].n_names++; }
+  return true;
 }
 
-static int _console_find_func( const char* str ) {
-  assert( str );
+// finds the node whose subtree holds every name starting with str. *label_pos is set to how far along that node's edge label str ends.
+// RETURNS node index, or -1 if no names start with str
+static int _trie_find_prefix( const char* str, int len, int* label_pos ) {
+  if ( 0 == _c_n_trie_nodes ) { return -1; }
+  int node = 0, pos = 0;
+  *label_pos = 0;
+  while ( pos < len ) {
+    int child = _c_trie_nodes[node].first_child;
+    while ( child >= 0 && _trie_label( &_c_trie_nodes[child] )[0] != str[pos] ) { child = _c_trie_nodes[child].next_sibling; }
+    if ( child < 0 ) { return -1; }
+    const char* label = _trie_label( &_c_trie_nodes[child] );
+    int i             = 0;
+    for ( ; i < _c_trie_nodes[child].label_len && pos < len; i++, pos++ ) {
+      if ( label[i] != str[pos] ) { return -1; }
+    }
+    node       = child;
+    *label_pos = i;
+  }
+  return node;
+}
 
-  for ( uint32_t i = 0; i < _n_c_funcs; i++ ) {
-    if ( strncmp( str, _c_funcs[i].str, APG_C_STR_MAX ) == 0 ) { return i; }
+// prints names in the subtree, alphabetically, until *n_left runs out
+static void _trie_print_names( int node, int* n_left ) {
+  if ( *n_left <= 0 ) { return; }
+  const _c_trie_node_t* n = &_c_trie_nodes[node];
+  if ( n->end_kind != _C_NAME_NONE ) {
+    apg_c_print( _name_str( n->end_kind, n->end_idx ) );
+    ( *n_left )--;
   }
-  return -1;
+  for ( int child = n->first_child; child >= 0 && *n_left > 0; child = _c_trie_nodes[child].next_sibling ) { _trie_print_names( child, n_left ); }
 }
 
-static int _console_find_builtin_func( const char* str ) {
-  assert( str );
+static void _name_table_put( _c_name_ref_t* table, uint32_t table_size, _c_name_ref_t ref ) {
+  uint32_t slot = ref.hash & ( table_size - 1 );
+  while ( table[slot].kind != _C_NAME_NONE ) { slot = ( slot + 1 ) & ( table_size - 1 ); }
+  table[slot] = ref;
+}
 
+// doubles the hash table and re-inserts every name if it would be over half full with one more. RETURNS false on allocation failure
+static bool _name_table_reserve_one( void ) {
+  if ( ( _c_n_names + 1 ) * 2 <= _c_name_table_size ) { return true; }
+  uint32_t new_size        = _c_name_table_size > 0 ? _c_name_table_size * 2 : 1024;
+  _c_name_ref_t* new_table = calloc( new_size, sizeof( _c_name_ref_t ) );
+  if ( !new_table ) { return false; }
+  for ( uint32_t i = 0; i < _c_name_table_size; i++ ) {
+    if ( _c_name_table[i].kind != _C_NAME_NONE ) { _name_table_put( new_table, new_size, _c_name_table[i] ); }
+  }
+  free( _c_name_table );
+  _c_name_table      = new_table;
+  _c_name_table_size = new_size;
+  return true;
+}
+
+// adds an already-stored builtin, function, or variable name to the hash table and the trie. RETURNS false on allocation failure
+static bool _add_name( _c_name_kind_t kind, int idx ) {
+  if ( !_name_table_reserve_one() ) { return false; }
+  if ( !_trie_insert( kind, idx ) ) { return false; }
+
+  _c_name_ref_t ref = { .kind = (uint8_t)kind, .idx = (uint32_t)idx };
+  ref.hash          = _hash_str( _name_str( kind, idx ) );
+  _name_table_put( _c_name_table, _c_name_table_size, ref );
+  _c_n_names++;
+  return true;
+}
+
+static void _add_builtin_names( void ) {
+  if ( _c_builtin_names_added ) { return; }
+  _c_builtin_names_added = true;
   for ( int i = 0; i < _c_n_built_in_commands; i++ ) {
-    if ( strncmp( str, _c_built_in_commands[i], APG_C_STR_MAX ) == 0 ) { return i; }
+    if ( _c_built_in_commands[i][0] != '\0' ) { _add_name( _C_NAME_BUILTIN, i ); }
   }
-  return -1;
 }
 
+// returns index or -1 if did not find
+static int _console_find_name( const char* str, _c_name_kind_t kind ) {
+  assert( str );
+
+  _add_builtin_names();
+  if ( 0 == _c_name_table_size ) { return -1; }
+  uint32_t hash = _hash_str( str );
+  for ( uint32_t slot = hash & ( _c_name_table_size - 1 );; slot = ( slot + 1 ) & ( _c_name_table_size - 1 ) ) {
+    _c_name_ref_t ref = _c_name_table[slot];
+    if ( _C_NAME_NONE == ref.kind ) { return -1; }
+    if ( ref.hash == hash && ref.kind == kind && strncmp( str, _name_str( ref.kind, ref.idx ), APG_C_STR_MAX ) == 0 ) { return ref.idx; }
+  }
+}
+
+static int _console_find_var( const char* str ) { return _console_find_name( str, _C_NAME_VAR ); }
+
+static int _console_find_func( const char* str ) { return _console_find_name( str, _C_NAME_FUNC ); }
+
+static int _console_find_builtin_func( const char* str ) { return _console_find_name( str, _C_NAME_BUILTIN ); }
+
 /* =======================================================================================================================
 user-entered text API. call these functions based on eg keyboard input.
 ======================================================================================================================= */
 
-static bool _parse_user_entered_instruction( const char* str ) {
+/* Splits len bytes of str into whitespace-separated tokens. A token starting with '#' begins a comment, which runs to the end of the line.
+   The first max_tokens tokens are copied into tokens, truncated to APG_C_STR_MAX - 1 bytes.
+   RETURNS the number of tokens in str, which may be more than max_tokens. */
+static int _tokenise( const char* str, int len, char tokens[][APG_C_STR_MAX], int max_tokens ) {
+  int n_tokens = 0;
+  for ( int i = 0; i < len; ) {
+    while ( i < len && isspace( (unsigned char)str[i] ) ) { i++; }
+    if ( i >= len || '#' == str[i] ) { break; }
+    int start = i;
+    while ( i < len && !isspace( (unsigned char)str[i] ) ) { i++; }
+    if ( n_tokens < max_tokens ) {
+      int n = i - start < APG_C_STR_MAX - 1 ? i - start : APG_C_STR_MAX - 1;
+      memcpy( tokens[n_tokens], &str[start], n );
+      tokens[n_tokens][n] = '\0';
+    }
+    n_tokens++;
+  }
+  return n_tokens;
+}
+
+static bool _exec_file( const char* filename ) {
+  char tmp[APG_C_STR_MAX];
+  if ( _c_exec_depth >= APG_C_MAX_EXEC_DEPTH ) {
+    snprintf( tmp, APG_C_STR_MAX, "ERROR: exec `%s` - too many nested scripts.", filename );
+    apg_c_print( tmp );
+    return false;
+  }
+  FILE* f_ptr = fopen( filename, "rb" );
+  if ( !f_ptr ) {
+    snprintf( tmp, APG_C_STR_MAX, "ERROR: exec could not open file `%s`.", filename );
+    apg_c_print( tmp );
+    return false;
+  }
+  fseek( f_ptr, 0, SEEK_END );
+  long sz = ftell( f_ptr );
+  rewind( f_ptr );
+  char* buf = sz > 0 ? malloc( sz ) : NULL;
+  if ( sz < 0 || ( sz > 0 && ( !buf || fread( buf, sz, 1, f_ptr ) != 1 ) ) ) {
+    snprintf( tmp, APG_C_STR_MAX, "ERROR: exec could not read file `%s`.", filename );
+    apg_c_print( tmp );
+    free( buf );
+    fclose( f_ptr );
+    return false;
+  }
+  fclose( f_ptr );
+
+  _c_exec_depth++;
+  bool result = apg_c_exec_buffer( buf, (int)sz );
+  _c_exec_depth--;
+  free( buf );
+  return result;
+}
+
+static long long _clamp_int( long long val, const apg_c_var_t* var ) {
+  if ( !var->has_range ) { return val; }
+  if ( (double)val < var->min_val ) { return (long long)var->min_val; }
+  if ( (double)val > var->max_val ) { return (long long)var->max_val; }
+  return val;
+}
+
+static double _clamp_double( double val, const apg_c_var_t* var ) {
+  if ( !var->has_range ) { return val; }
+  if ( val < var->min_val ) { return var->min_val; }
+  if ( val > var->max_val ) { return var->max_val; }
+  return val;
+}
+
+// sets a variable's value from a string, clamped to its range if it has one. if the value changes the change is counted and the callback is called.
+static void _set_var_from_str( apg_c_var_t* var, const char* str ) {
+  assert( var && var->var_ptr && str );
+
+  union {
+    bool b;
+    int32_t i32;
+    uint32_t u32;
+    int64_t i64;
+    float f;
+    double d;
+  } val;
+  size_t sz = 0;
+  switch ( var->datatype ) {
+  case APG_C_BOOL: {
+    val.b = 0 != _clamp_int( strtoll( str, NULL, 10 ), var );
+    sz    = sizeof( bool );
+  } break;
+  case APG_C_INT32: {
+    val.i32 = (int32_t)_clamp_int( strtoll( str, NULL, 10 ), var );
+    sz      = sizeof( int32_t );
+  } break;
+  case APG_C_UINT32: {
+    val.u32 = (uint32_t)_clamp_int( strtoll( str, NULL, 10 ), var );
+    sz      = sizeof( uint32_t );
+  } break;
+  case APG_C_INT64: {
+    val.i64 = (int64_t)_clamp_int( strtoll( str, NULL, 10 ), var );
+    sz      = sizeof( int64_t );
+  } break;
+  case APG_C_FLOAT: {
+    val.f = (float)_clamp_double( strtod( str, NULL ), var );
+    sz    = sizeof( float );
+  } break;
+  case APG_C_DOUBLE: {
+    val.d = _clamp_double( strtod( str, NULL ), var );
+    sz    = sizeof( double );
+  } break;
+  default: return; // do nothing for complex data types
+  } // endswitch
+
+  if ( memcmp( var->var_ptr, &val, sz ) == 0 ) { return; }
+  memcpy( var->var_ptr, &val, sz );
+  var->last_change = ++_c_var_change_count;
+  if ( var->on_change ) { var->on_change( var ); }
+}
+
+static bool _parse_user_entered_instruction( const char* str, int len ) {
   assert( str );
 
-  char one[APG_C_STR_MAX], two[APG_C_STR_MAX], three[APG_C_STR_MAX], four[APG_C_STR_MAX];
+  char tokens[2][APG_C_STR_MAX];
+  char *one = tokens[0], *two = tokens[1];
   char tmp[APG_C_STR_MAX];
-  one[0] = two[0] = three[0] = '\0';
-  int n                      = sscanf( str, "%s %s %s %s", one, two, three, four );
+  int n = _tokenise( str, len, tokens, 2 );
   switch ( n ) {
   case 0: return true; // this would be simply '\n'
   case 1: {
     // search for func match
     int func_idx = _console_find_func( one );
     if ( func_idx >= 0 ) {
-      bool res = _c_funcs[func_idx].func_ptr( NULL );
+      bool res = _call_func( func_idx, NULL );
       if ( !res ) {
         snprintf( tmp, APG_C_STR_MAX, "ERROR: function `%s` returned error.", one );
         apg_c_print( tmp );
@@ -159,12 +692,16 @@ static bool _parse_user_entered_instruction( const char* str ) {
       _list_c_funcs();
       return true;
     }
+    if ( strncmp( one, "profile", APG_C_STR_MAX ) == 0 ) {
+      _profile();
+      return true;
+    }
 
     // then variable. equivalent to 'get myvariable' but no 'get' command required in this console.
     int var_idx = _console_find_var( one );
     if ( var_idx >= 0 ) {
-      apg_c_var_datatype_t dt = _c_vars[var_idx].datatype;
-      void* var_ptr           = _c_vars[var_idx].var_ptr;
+      apg_c_var_datatype_t dt = _var_at( var_idx )->datatype;
+      void* var_ptr           = _var_at( var_idx )->var_ptr;
       assert( var_ptr );
       tmp[0] = '\0';
       switch ( dt ) {
@@ -177,9 +714,15 @@ static bool _parse_user_entered_instruction( const char* str ) {
       case APG_C_UINT32: {
         snprintf( tmp, APG_C_STR_MAX, "%s %u.", one, *(uint32_t*)var_ptr );
       } break;
+      case APG_C_INT64: {
+        snprintf( tmp, APG_C_STR_MAX, "%s %lld.", one, (long long)*(int64_t*)var_ptr );
+      } break;
       case APG_C_FLOAT: {
         snprintf( tmp, APG_C_STR_MAX, "%s %f.", one, *(float*)var_ptr );
       } break;
+      case APG_C_DOUBLE: {
+        snprintf( tmp, APG_C_STR_MAX, "%s %f.", one, *(double*)var_ptr );
+      } break;
       default: {
         snprintf( tmp, APG_C_STR_MAX, "%s OTHER", one );
       } break; // some other data type
@@ -195,10 +738,9 @@ static bool _parse_user_entered_instruction( const char* str ) {
   } break;
 
   case 2: {
-    float fval = (float)atof( two );
     int func_idx = _console_find_func( one );
     if ( func_idx >= 0 ) {
-      bool res = _c_funcs[func_idx].func_ptr( two ); // give 2nd token as arg string
+      bool res = _call_func( func_idx, two ); // give 2nd token as arg string
       if ( !res ) {
         snprintf( tmp, APG_C_STR_MAX, "ERROR: function `%s` returned error.", one );
         apg_c_print( tmp );
@@ -206,28 +748,12 @@ static bool _parse_user_entered_instruction( const char* str ) {
       return true;
     }
 
+    if ( strncmp( one, "exec", APG_C_STR_MAX ) == 0 ) { return _exec_file( two ); }
+
     // assume this is equiv to "set myvariable value" with an implied "set"
     int var_idx = _console_find_var( one );
     if ( var_idx >= 0 ) {
-      apg_c_var_datatype_t dt = _c_vars[var_idx].datatype;
-      void* var_ptr           = _c_vars[var_idx].var_ptr;
-      assert( var_ptr );
-      tmp[0] = '\0';
-      switch ( dt ) {
-      case APG_C_BOOL: {
-        *(bool*)var_ptr = (bool)atoi( two );
-      } break;
-      case APG_C_INT32: {
-        *(int32_t*)var_ptr = (int32_t)atoi( two );
-      } break;
-      case APG_C_UINT32: {
-        *(uint32_t*)var_ptr = (uint32_t)atoi( two );
-      } break;
-      case APG_C_FLOAT: {
-        *(float*)var_ptr = fval;
-      } break;
-      default: break; // do nothing for complex data types
-      }               // endswitch
+      _set_var_from_str( _var_at( var_idx ), two );
       return true;
     } else {
       snprintf( tmp, APG_C_STR_MAX, "ERROR: `%s` is not a recognised variable name.", one );
@@ -269,22 +795,36 @@ bool apg_c_append_user_entered_text( const char* str ) {
       _c_user_entered_text[i] = '\0';
       _apg_c_command_hist_append( _c_user_entered_text );
       apg_c_print( _c_user_entered_text );
-      bool parsed             = _parse_user_entered_instruction( _c_user_entered_text );
+      bool parsed             = _parse_user_entered_instruction( _c_user_entered_text, i );
       _c_user_entered_text[0] = '\0';
+      _prompt_changed();
       return parsed;
     }
   }
 
-  _c_redraw_required = true;
+  _prompt_changed();
   return true;
 }
 
+bool apg_c_exec_buffer( const char* buf, int len ) {
+  assert( buf );
+
+  bool all_parsed = true;
+  for ( int i = 0; i < len; ) {
+    const char* nl_ptr = memchr( &buf[i], '\n', len - i );
+    int line_end       = nl_ptr ? (int)( nl_ptr - buf ) : len;
+    if ( !_parse_user_entered_instruction( &buf[i], line_end - i ) ) { all_parsed = false; }
+    i = line_end + 1;
+  }
+  return all_parsed;
+}
+
 void apg_c_reuse_hist( int hist ) {
   int32_t idx             = _c_latest_command_in_history - hist;
   idx                     = idx < 0 ? APG_C_MAX_COMMAND_HIST - 1 : idx % APG_C_MAX_COMMAND_HIST;
   _c_user_entered_text[0] = '\0';
   apg_c_strncat( _c_user_entered_text, _c_command_history[idx], APG_C_STR_MAX, APG_C_STR_MAX );
-  _c_redraw_required = true;
+  _prompt_changed();
 }
 
 // WARNING(Anton) not unicode-aware!
@@ -292,12 +832,12 @@ void apg_c_backspace( void ) {
   int uet_len = apg_c_strnlen( _c_user_entered_text, APG_C_STR_MAX );
   if ( uet_len < 1 ) { return; }
   _c_user_entered_text[uet_len - 1] = '\0';
-  _c_redraw_required                = true;
+  _prompt_changed();
 }
 
 void apg_c_clear_user_entered_text( void ) {
   _c_user_entered_text[0] = '\0';
-  _c_redraw_required      = true;
+  _prompt_changed();
 }
 
 // WARNING(Anton) - assumes string is ASCII
@@ -316,83 +856,159 @@ void apg_c_autocomplete() {
   for ( int k = 0; k < token_span; k++ ) { token[k] = _c_user_entered_text[k + i]; }
   token[token_span] = '\0';
 
-  int n_matching        = 0;
-  int last_matching_idx = -1;
-  int section_matching  = -1;
-  // check built-in funcs
-  for ( int l = 0; l < _c_n_built_in_commands; l++ ) {
-    char* res = strstr( _c_built_in_commands[l], token );
-    if ( _c_built_in_commands[l] == res ) {
-      n_matching++;
-      last_matching_idx = l;
-      section_matching  = 0;
-      apg_c_print( _c_built_in_commands[l] );
+  _add_builtin_names();
+  int label_pos = 0;
+  int node      = _trie_find_prefix( token, token_span, &label_pos );
+  if ( node < 0 ) { return; }
+
+  // complete up to the longest prefix shared by all candidates: the rest of this edge, then down any unbranching path
+  char completion[APG_C_STR_MAX];
+  int completion_len = 0, lcp_node = node;
+  for ( int i = label_pos; i < _c_trie_nodes[node].label_len; i++ ) { completion[completion_len++] = _trie_label( &_c_trie_nodes[node] )[i]; }
+  while ( _C_NAME_NONE == _c_trie_nodes[lcp_node].end_kind && _c_trie_nodes[lcp_node].first_child >= 0 &&
+          _c_trie_nodes[_c_trie_nodes[lcp_node].first_child].next_sibling < 0 ) {
+    lcp_node = _c_trie_nodes[lcp_node].first_child;
+    for ( int i = 0; i < _c_trie_nodes[lcp_node].label_len && completion_len < APG_C_STR_MAX - 1; i++ ) {
+      completion[completion_len++] = _trie_label( &_c_trie_nodes[lcp_node] )[i];
     }
   }
-
-  // check cfuncs
-  for ( uint32_t m = 0; m < _n_c_funcs; m++ ) {
-    char* res = strstr( _c_funcs[m].str, token );
-    if ( _c_funcs[m].str == res ) {
-      n_matching++;
-      last_matching_idx = m;
-      section_matching  = 1;
-      apg_c_print( _c_funcs[m].str );
-    }
+  completion[completion_len] = '\0';
+  if ( completion_len > 0 ) {
+    apg_c_strncat( _c_user_entered_text, completion, APG_C_STR_MAX, APG_C_STR_MAX );
+    _prompt_changed();
   }
 
-  // check variables
-  for ( uint32_t o = 0; o < _n_c_vars; o++ ) {
-    char* res = strstr( _c_vars[o].str, token );
-    if ( _c_vars[o].str == res ) {
-      n_matching++;
-      last_matching_idx = o;
-      section_matching  = 2;
-      apg_c_print( _c_vars[o].str );
+  // list the candidates if there is still a choice to make
+  int n_candidates = _c_trie_nodes[node].n_names;
+  if ( n_candidates > 1 ) {
+    int n_left = APG_C_MAX_AUTOCOMPLETE_CANDIDATES;
+    _trie_print_names( node, &n_left );
+    if ( n_candidates > APG_C_MAX_AUTOCOMPLETE_CANDIDATES ) {
+      char tmp[APG_C_STR_MAX];
+      snprintf( tmp, APG_C_STR_MAX, "...and %i more.", n_candidates - APG_C_MAX_AUTOCOMPLETE_CANDIDATES );
+      apg_c_print( tmp );
     }
   }
-  if ( 1 == n_matching ) {
-    switch ( section_matching ) {
-    case 0: apg_c_strncat( _c_user_entered_text, &_c_built_in_commands[last_matching_idx][token_span], APG_C_STR_MAX, APG_C_STR_MAX ); break;
-    case 1: apg_c_strncat( _c_user_entered_text, &_c_funcs[last_matching_idx].str[token_span], APG_C_STR_MAX, APG_C_STR_MAX ); break;
-    case 2: apg_c_strncat( _c_user_entered_text, &_c_vars[last_matching_idx].str[token_span], APG_C_STR_MAX, APG_C_STR_MAX ); break;
-    default: assert( false ); break;
-    } // endswitch
-  }
 }
 
 /* =======================================================================================================================
 console output text API.
 ======================================================================================================================= */
 void apg_c_output_clear( void ) {
-  c_output_lines_oldest = c_output_lines_newest = -1;
-  c_n_output_lines                              = 0;
-  _c_redraw_required                            = true;
+  _c_output_text_head = _c_output_lines_oldest = 0;
+  c_n_output_lines                             = 0;
+  _c_redraw_required                           = true;
+  _c_redraw_all                                = true;
+}
+
+bool apg_c_output_reserve( int max_lines, int max_bytes ) {
+  if ( max_lines < 1 || max_bytes < 2 ) { return false; }
+
+  char* text              = malloc( max_bytes );
+  _c_output_line_t* lines = malloc( max_lines * sizeof( _c_output_line_t ) );
+  if ( !text || !lines ) {
+    free( text );
+    free( lines );
+    return false;
+  }
+  free( _c_output_text );
+  free( _c_output_lines );
+  _c_output_text           = text;
+  _c_output_text_capacity  = (uint32_t)max_bytes;
+  _c_output_lines          = lines;
+  _c_output_lines_capacity = (uint32_t)max_lines;
+  apg_c_output_clear();
+  return true;
+}
+
+int apg_c_count_lines( void ) {
+  apg_c_flush_print_queue();
+  return c_n_output_lines;
+}
+
+bool apg_c_print_mt( const char* str ) {
+  assert( str );
+
+  // claim a position. the slot there is free once the consumer has finished with it the previous time around the queue.
+  uint32_t pos = _atomic_load_acquire( &_c_print_queue_tail );
+  _c_print_slot_t* slot;
+  for ( ;; ) {
+    slot          = &_c_print_queue[pos & ( APG_C_PRINT_QUEUE_LEN - 1 )];
+    int32_t ahead = (int32_t)( _atomic_load_acquire( &slot->sequence ) - ( pos & ~( APG_C_PRINT_QUEUE_LEN - 1u ) ) );
+    if ( 0 == ahead ) {
+      if ( _atomic_cas( &_c_print_queue_tail, pos, pos + 1 ) ) { break; }
+    } else if ( ahead < 0 ) { // full
+      _atomic_increment( &_c_n_prints_dropped );
+      return false;
+    }
+    pos = _atomic_load_acquire( &_c_print_queue_tail ); // another producer got there first
+  }
+
+  int len = apg_c_strnlen( str, APG_C_STR_MAX - 1 );
+  memcpy( slot->str, str, len );
+  slot->str[len] = '\0';
+  _atomic_store_release( &slot->sequence, ( pos & ~( APG_C_PRINT_QUEUE_LEN - 1u ) ) + 1 ); // ready to read
+  return true;
 }
 
-int apg_c_count_lines( void ) { return c_n_output_lines; }
+void apg_c_flush_print_queue( void ) {
+  for ( ;; ) {
+    uint32_t pos          = _c_print_queue_head;
+    _c_print_slot_t* slot = &_c_print_queue[pos & ( APG_C_PRINT_QUEUE_LEN - 1 )];
+    if ( _atomic_load_acquire( &slot->sequence ) != ( pos & ~( APG_C_PRINT_QUEUE_LEN - 1u ) ) + 1 ) { break; } // not written yet
+    apg_c_print( slot->str );
+    _atomic_store_release( &slot->sequence, ( pos & ~( APG_C_PRINT_QUEUE_LEN - 1u ) ) + APG_C_PRINT_QUEUE_LEN ); // free for the next time around
+    _c_print_queue_head = pos + 1;
+  }
+
+  uint32_t n_dropped = _atomic_load_acquire( &_c_n_prints_dropped );
+  if ( n_dropped != _c_n_prints_dropped_reported ) {
+    char tmp[APG_C_STR_MAX];
+    snprintf( tmp, APG_C_STR_MAX, "WARNING: %u lines from apg_c_print_mt() dropped. print queue was full.", n_dropped - _c_n_prints_dropped_reported );
+    apg_c_print( tmp );
+    _c_n_prints_dropped_reported = n_dropped;
+  }
+}
+
+uint32_t apg_c_count_dropped_prints( void ) { return _atomic_load_acquire( &_c_n_prints_dropped ); }
 
 void apg_c_print( const char* str ) {
   assert( str );
 
-  c_output_lines_newest = ( c_output_lines_newest + 1 ) % APG_C_OUTPUT_LINES_MAX;
-  c_n_output_lines      = c_n_output_lines < APG_C_OUTPUT_LINES_MAX ? c_n_output_lines + 1 : APG_C_OUTPUT_LINES_MAX;
-  if ( c_output_lines_newest == c_output_lines_oldest ) { c_output_lines_oldest = ( c_output_lines_oldest + 1 ) % APG_C_OUTPUT_LINES_MAX; }
-  if ( -1 == c_output_lines_oldest ) { c_output_lines_oldest = c_output_lines_newest; }
-  strncpy( c_output_lines[c_output_lines_newest], str, APG_C_STR_MAX - 1 );
+  if ( !_c_output_text && !apg_c_output_reserve( APG_C_OUTPUT_LINES_MAX, APG_C_OUTPUT_LINES_MAX * APG_C_STR_MAX ) ) { return; }
+
+  uint32_t len = (uint32_t)apg_c_strnlen( str, APG_C_STR_MAX - 1 );
+  if ( len + 1 > _c_output_text_capacity ) { len = _c_output_text_capacity - 1; }
+  if ( _c_output_text_head + len + 1 > _c_output_text_capacity ) {
+    // doesn't fit before the end of the text buffer. drop the lines stored there and carry on from the start.
+    while ( c_n_output_lines > 0 && _c_output_lines[_c_output_lines_oldest].offset >= _c_output_text_head ) { _drop_oldest_output_line(); }
+    _c_output_text_head = 0;
+  }
+  // drop the oldest lines if they are about to be overwritten, or if there are no free line slots
+  while ( c_n_output_lines > 0 ) {
+    uint32_t oldest_offset = _c_output_lines[_c_output_lines_oldest].offset;
+    bool overwritten       = oldest_offset >= _c_output_text_head && oldest_offset < _c_output_text_head + len + 1;
+    if ( !overwritten && (uint32_t)c_n_output_lines < _c_output_lines_capacity ) { break; }
+    _drop_oldest_output_line();
+  }
+
+  uint32_t line_idx                = ( _c_output_lines_oldest + c_n_output_lines ) % _c_output_lines_capacity;
+  _c_output_lines[line_idx].offset = _c_output_text_head;
+  _c_output_lines[line_idx].len    = len;
+  memcpy( &_c_output_text[_c_output_text_head], str, len );
+  _c_output_text[_c_output_text_head + len] = '\0';
+  _c_output_text_head += len + 1;
+  c_n_output_lines++;
 
   _c_redraw_required = true;
+  if ( _c_n_lines_to_scroll < (int)_c_output_lines_capacity ) { _c_n_lines_to_scroll++; }
 }
 
 void apg_c_dump_to_stdout( void ) {
-  if ( c_output_lines_oldest < 0 || c_output_lines_newest < 0 ) { return; }
-  int idx = c_output_lines_oldest;
-  for ( int count = 0; count < APG_C_OUTPUT_LINES_MAX; count++ ) {
-    printf( "%i) %s\n", idx, c_output_lines[idx] );
-    if ( idx == c_output_lines_newest ) { return; }
-    idx = ( idx + 1 ) % APG_C_OUTPUT_LINES_MAX;
+  apg_c_flush_print_queue();
+  for ( int i = 0; i < c_n_output_lines; i++ ) {
+    printf( "%u) %s\n", ( _c_output_lines_oldest + i ) % _c_output_lines_capacity, _output_line( c_n_output_lines - 1 - i ) );
   }
-  printf( "> %s\n", _c_user_entered_text );
 }
 
 /* =======================================================================================================================
@@ -402,12 +1018,18 @@ bool apg_c_register_func( const char* str, bool ( *fptr )( const char* arg_str )
   assert( str );
   assert( fptr );
 
-  if ( _n_c_funcs >= APG_C_FUNCS_MAX ) { return false; }
   int idx = _console_find_func( str );
   if ( idx >= 0 ) { return false; }
-  idx = _n_c_funcs++;
-  strncpy( _c_funcs[idx].str, str, APG_C_STR_MAX - 1 );
+  apg_c_func_t* funcs = _reserve( _c_funcs, &_c_funcs_capacity, _n_c_funcs + 1, sizeof( apg_c_func_t ) );
+  if ( !funcs ) { return false; }
+  _c_funcs = funcs;
+  idx      = _n_c_funcs;
+  memset( &_c_funcs[idx], 0, sizeof( apg_c_func_t ) ); // also zeroes the profile stats
+  _c_funcs[idx].str = _intern_str( str, apg_c_strnlen( str, APG_C_STR_MAX - 1 ) );
+  if ( !_c_funcs[idx].str ) { return false; }
   _c_funcs[idx].func_ptr = fptr;
+  if ( !_add_name( _C_NAME_FUNC, idx ) ) { return false; }
+  _n_c_funcs++;
 
   return true;
 }
@@ -415,17 +1037,25 @@ bool apg_c_register_func( const char* str, bool ( *fptr )( const char* arg_str )
 bool apg_c_register_var( const char* str, void* var_ptr, apg_c_var_datatype_t datatype ) {
   assert( str && var_ptr );
 
-  if ( _n_c_vars >= APG_C_VARS_MAX ) { return false; }
   int idx = _console_find_var( str );
   if ( idx >= 0 ) { return false; }
   idx = _console_find_builtin_func( str );
   if ( idx >= 0 ) { return false; }
   idx = _console_find_func( str );
   if ( idx >= 0 ) { return false; }
-  idx = _n_c_vars++;
-  strncpy( _c_vars[idx].str, str, APG_C_STR_MAX - 1 );
-  _c_vars[idx].var_ptr  = var_ptr;
-  _c_vars[idx].datatype = datatype;
+  if ( !_vars_reserve_one() ) { return false; }
+  idx              = _n_c_vars;
+  apg_c_var_t* var = _var_at( idx );
+  var->str         = _intern_str( str, apg_c_strnlen( str, APG_C_STR_MAX - 1 ) );
+  if ( !var->str ) { return false; }
+  var->var_ptr     = var_ptr;
+  var->datatype    = datatype;
+  var->on_change   = NULL;
+  var->min_val     = var->max_val = 0.0;
+  var->has_range   = false;
+  var->last_change = 0;
+  if ( !_add_name( _C_NAME_VAR, idx ) ) { return false; }
+  _n_c_vars++;
   return true;
 }
 
@@ -434,58 +1064,197 @@ apg_c_var_t* apg_c_get_var( const char* str ) {
 
   int idx = _console_find_var( str );
   if ( idx < 0 ) { return NULL; }
-  return &_c_vars[idx];
+  return _var_at( idx );
+}
+
+bool apg_c_set_var_callback( const char* str, void ( *on_change )( const apg_c_var_t* var ) ) {
+  apg_c_var_t* var = apg_c_get_var( str );
+  if ( !var ) { return false; }
+  var->on_change = on_change;
+  return true;
+}
+
+bool apg_c_set_var_range( const char* str, double min_val, double max_val ) {
+  apg_c_var_t* var = apg_c_get_var( str );
+  if ( !var || min_val > max_val ) { return false; }
+  var->min_val   = min_val;
+  var->max_val   = max_val;
+  var->has_range = true;
+  return true;
+}
+
+uint64_t apg_c_count_var_changes( void ) { return _c_var_change_count; }
+
+void apg_c_set_timer_func( double ( *timer_func )( void ) ) { _c_timer_func = timer_func; }
+
+void apg_c_free( void ) {
+  for ( uint32_t i = 0; i < _n_c_var_blocks; i++ ) { free( _c_var_blocks[i] ); }
+  free( _c_var_blocks );
+  _c_var_blocks   = NULL;
+  _n_c_var_blocks = _n_c_vars = 0;
+  free( _c_funcs );
+  _c_funcs   = NULL;
+  _n_c_funcs = _c_funcs_capacity = 0;
+  while ( _c_arena ) {
+    _c_arena_block_t* next = _c_arena->next;
+    free( _c_arena );
+    _c_arena = next;
+  }
+  free( _c_name_table );
+  _c_name_table      = NULL;
+  _c_name_table_size = _c_n_names = 0;
+  free( _c_trie_nodes );
+  _c_trie_nodes   = NULL;
+  _c_n_trie_nodes = _c_trie_nodes_capacity = 0;
+  _c_builtin_names_added                   = false;
+  free( _c_output_text );
+  free( _c_output_lines );
+  _c_output_text          = NULL;
+  _c_output_lines         = NULL;
+  _c_output_text_capacity = _c_output_lines_capacity = 0;
+  apg_c_output_clear();
 }
 
 /* =======================================================================================================================
 rendering API
 ======================================================================================================================= */
-bool apg_c_draw_to_image_mem( uint8_t* img_ptr, int w, int h, int n_channels, uint8_t* background_colour ) {
-  assert( img_ptr );
+#define APG_C_ROW_HEIGHT_PX 16 // height of each line of text in the image
+
+// fill rows y0 to y1 (exclusive) with the background colour.
+// the first row is built by doubling memcpy()s of the pixel pattern, and then copied to the other rows, so the work is done by the (vectorised) C library.
+static void _fill_background( uint8_t* img_ptr, int w, int n_channels, int y0, int y1, const uint8_t* background_colour ) {
+  if ( y1 <= y0 ) { return; }
+  const size_t row_stride = (size_t)w * n_channels;
+  uint8_t* first_row      = &img_ptr[row_stride * y0];
+  memcpy( first_row, background_colour, n_channels );
+  for ( size_t n_filled = n_channels; n_filled < row_stride; ) {
+    size_t n_copy = n_filled < row_stride - n_filled ? n_filled : row_stride - n_filled;
+    memcpy( &first_row[n_filled], first_row, n_copy );
+    n_filled += n_copy;
+  }
+  for ( int y = y0 + 1; y < y1; y++ ) { memcpy( &img_ptr[row_stride * y], first_row, row_stride ); }
+}
 
-  const int row_stride    = w * n_channels;
-  const int row_height_px = 16;
+// redraws one row of text, with its top at pixel row y. str may be NULL for an empty row.
+static void _draw_text_row( uint8_t* img_ptr, int w, int n_channels, int y, const char* str, const uint8_t* background_colour ) {
+  const int row_stride = w * n_channels;
   // text properties
   const int thickness = 1;
   const int outlines  = 1;
 
-  if ( row_stride < 1 ) { return false; }
+  // the font only writes text and outline pixels, so it can go straight on top of the background
+  _fill_background( img_ptr, w, n_channels, y, y + APG_C_ROW_HEIGHT_PX, background_colour );
+  if ( str ) { apg_pixfont_str_into_image( str, &img_ptr[row_stride * y], w, APG_C_ROW_HEIGHT_PX, n_channels, 0xFF, 0xFF, 0xFF, 0xFF, thickness, outlines ); }
+}
 
-  memset( img_ptr, 0, row_stride * h );
+// redraws the row of scrolling output that is i lines above the prompt. 0 is the newest line.
+static void _draw_output_row( uint8_t* img_ptr, int w, int h, int n_channels, int i, const uint8_t* background_colour ) {
+  const char* str = NULL;
+  if ( i < c_n_output_lines ) { str = _output_line( i ); }
+  _draw_text_row( img_ptr, w, n_channels, h - APG_C_ROW_HEIGHT_PX * ( i + 2 ), str, background_colour );
+}
+
+bool apg_c_draw_to_image_mem( uint8_t* img_ptr, int w, int h, int n_channels, uint8_t* background_colour ) {
+  assert( img_ptr );
+
+  apg_c_flush_print_queue();
+
+  const int row_stride = w * n_channels;
+  if ( row_stride < 1 || n_channels > 4 ) { return false; }
+
+  const int n_rows = h / APG_C_ROW_HEIGHT_PX; // rows of text that fit in the image. the bottom row is the prompt.
+  if ( n_rows < 1 ) { return false; }         // not even space for one line
+  const int n_output_rows = n_rows - 1;
 
-  // draw scrolling text output above the prompt line
-  int n_lines = apg_c_count_lines();
-  for ( int i = 0; i < n_lines; i++ ) {
-    int line_idx = c_output_lines_newest - i;
-    if ( line_idx < 0 ) { line_idx += APG_C_OUTPUT_LINES_MAX; }
-    int row_idx = h * row_stride - ( row_height_px * row_stride ) * ( i + 2 );
-    if ( row_idx < 0 ) { break; } // don't bother if entire row above upper image bound
-    apg_pixfont_str_into_image( c_output_lines[line_idx], &img_ptr[row_idx], w, row_height_px, n_channels, 0xFF, 0xFF, 0xFF, 0xFF, thickness, outlines );
+  // a different image, or different settings, means nothing in the image can be reused
+  if ( img_ptr != _c_last_draw.img_ptr || w != _c_last_draw.w || h != _c_last_draw.h || n_channels != _c_last_draw.n_channels ||
+       memcmp( background_colour, _c_last_draw.background_colour, n_channels ) != 0 ) {
+    _c_redraw_all            = true;
+    _c_last_draw.img_ptr     = img_ptr;
+    _c_last_draw.w           = w;
+    _c_last_draw.h           = h;
+    _c_last_draw.n_channels  = n_channels;
+    memcpy( _c_last_draw.background_colour, background_colour, n_channels );
   }
-  { // draw user-entered text on the bottom of the image
+
+  if ( _c_redraw_all ) {
+    // rows above the top line of text are just background
+    const int top_y = h - n_rows * APG_C_ROW_HEIGHT_PX;
+    _fill_background( img_ptr, w, n_channels, 0, top_y, background_colour );
+    for ( int i = 0; i < n_output_rows; i++ ) { _draw_output_row( img_ptr, w, h, n_channels, i, background_colour ); }
+  } else if ( _c_n_lines_to_scroll >= n_output_rows ) {
+    for ( int i = 0; i < n_output_rows; i++ ) { _draw_output_row( img_ptr, w, h, n_channels, i, background_colour ); }
+  } else if ( _c_n_lines_to_scroll > 0 ) {
+    // scroll the existing output up, then draw the new lines underneath it
+    const int scroll_px = _c_n_lines_to_scroll * APG_C_ROW_HEIGHT_PX;
+    const int top_y     = h - n_rows * APG_C_ROW_HEIGHT_PX;
+    const int bottom_y  = h - APG_C_ROW_HEIGHT_PX; // top of the prompt
+    memmove( &img_ptr[row_stride * top_y], &img_ptr[row_stride * ( top_y + scroll_px )], (size_t)row_stride * ( bottom_y - top_y - scroll_px ) );
+    for ( int i = 0; i < _c_n_lines_to_scroll; i++ ) { _draw_output_row( img_ptr, w, h, n_channels, i, background_colour ); }
+    // lines that dropped out of the output history scrolled up too, so blank them
+    for ( int i = c_n_output_lines; i < _c_last_draw.n_output_lines + _c_n_lines_to_scroll && i < n_output_rows; i++ ) {
+      _draw_output_row( img_ptr, w, h, n_channels, i, background_colour );
+    }
+  }
+
+  if ( _c_redraw_all || _c_redraw_prompt ) { // draw user-entered text on the bottom of the image
     char uet_str[APG_C_STR_MAX];
     strcpy( uet_str, "> " );
     apg_c_strncat( uet_str, _c_user_entered_text, APG_C_STR_MAX, APG_C_STR_MAX );
-    int bottom_row_idx = h * row_stride - ( row_height_px * row_stride );
-    if ( bottom_row_idx < 0 ) { return false; } // not even space for one line
-    apg_pixfont_str_into_image( uet_str, &img_ptr[bottom_row_idx], w, row_height_px, n_channels, 0xFF, 0xFF, 0xFF, 0xFF, thickness, outlines );
-  }
-
-  // set background colour wherever there is no text/outline
-  // NOTE(Anton) this is not ideal for performance - use a second background image instead and blt onto it or render both
-  for ( int y = 0; y < h; y++ ) {
-    for ( int x = 0; x < w; x++ ) {
-      int sum = 0;
-      for ( int c = 0; c < n_channels; c++ ) {
-        int idx = row_stride * y + x * n_channels + c;
-        sum += img_ptr[idx];
-      }
-      if ( 0 == sum ) { memcpy( &img_ptr[row_stride * y + x * n_channels], background_colour, n_channels ); }
+    _draw_text_row( img_ptr, w, n_channels, h - APG_C_ROW_HEIGHT_PX, uet_str, background_colour );
+  }
+
+  _c_last_draw.n_output_lines = c_n_output_lines;
+  _c_redraw_required = _c_redraw_all = _c_redraw_prompt = false;
+  _c_n_lines_to_scroll                                  = 0;
+  return true;
+}
+
+// lays out one line of text with its top-left at x,y into instances, from index *n_instances, which is incremented by the number needed.
+// glyphs outside the line's row, or right of w, are left out - the same as they are clipped when drawing into an image.
+static void _line_to_glyph_instances( const char* str, float x, float y, int w, apg_c_glyph_instance_t* instances, int max_instances, int* n_instances ) {
+  apg_pixfont_quad_t quads[APG_C_STR_MAX]; // lines are shorter than APG_C_STR_MAX bytes so never have more glyphs than this
+  int n_quads = apg_pixfont_str_to_quads( str, x, y, 1, quads, APG_C_STR_MAX );
+  for ( int i = 0; i < n_quads; i++ ) {
+    if ( quads[i].x0 >= (float)w || quads[i].y0 >= y + APG_C_ROW_HEIGHT_PX ) { continue; }
+    if ( *n_instances < max_instances ) {
+      apg_c_glyph_instance_t* instance = &instances[*n_instances];
+      instance->x0                     = quads[i].x0;
+      instance->y0                     = quads[i].y0;
+      instance->x1                     = quads[i].x1;
+      instance->y1                     = quads[i].y1;
+      instance->u0                     = quads[i].u0;
+      instance->v0                     = quads[i].v0;
+      instance->u1                     = quads[i].u1;
+      instance->v1                     = quads[i].v1;
+      memset( instance->rgba, 0xFF, 4 );
     }
+    ( *n_instances )++;
+  }
+}
+
+int apg_c_draw_to_glyph_instances( int w, int h, apg_c_glyph_instance_t* instances, int max_instances ) {
+  if ( w < 1 || max_instances < 0 || ( !instances && max_instances > 0 ) ) { return 0; }
+
+  apg_c_flush_print_queue();
+
+  const int n_rows = h / APG_C_ROW_HEIGHT_PX;
+  if ( n_rows < 1 ) { return 0; }
+
+  int n_instances = 0;
+  for ( int i = 0; i < n_rows - 1 && i < c_n_output_lines; i++ ) {
+    _line_to_glyph_instances( _output_line( i ), 0.0f, (float)( h - APG_C_ROW_HEIGHT_PX * ( i + 2 ) ), w, instances, max_instances, &n_instances );
   }
+  char uet_str[APG_C_STR_MAX];
+  strcpy( uet_str, "> " );
+  apg_c_strncat( uet_str, _c_user_entered_text, APG_C_STR_MAX, APG_C_STR_MAX );
+  _line_to_glyph_instances( uet_str, 0.0f, (float)( h - APG_C_ROW_HEIGHT_PX ), w, instances, max_instances, &n_instances );
 
   _c_redraw_required = false;
-  return true;
+  return n_instances;
 }
 
-bool apg_c_image_redraw_required() { return _c_redraw_required; }
+bool apg_c_image_redraw_required() {
+  apg_c_flush_print_queue();
+  return _c_redraw_required;
+}
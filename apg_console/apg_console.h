@@ -11,6 +11,16 @@ Version History:
   2020/01/04 - Moved to apg libraries repository. Minor tweaks from testing in a game integration.
   2020/01/06 - Reduced interface. Moved from stored float cvars to addresses of existing vars. Data type is also specified for bool/int/uint/float support.
   2020/03/28 - Improved function callback parameter handling (float->string).
+  2026/10/18 - Incremental image redraws. Only the prompt, or newly printed lines, are redrawn and existing output is scrolled in the image.
+  2026/10/18 - Background is filled before text is drawn, rather than re-scanning the image for unwritten pixels, which also replaced black text outlines.
+  2026/10/18 - Hash table lookup of variables and functions by name. Autocompletion searches a sorted index of names, and lists candidates alphabetically.
+  2026/10/18 - Autocompletion uses a radix trie of all names, completes the longest prefix shared by all candidates, and lists a limited number of candidates.
+  2026/10/18 - No fixed limit on variables and functions. Names are stored in a string arena. Output lines are stored by length in a resizable ring buffer.
+  2026/10/18 - apg_c_print_mt() for lock-free logging from other threads.
+  2026/10/18 - apg_c_exec_buffer() and `exec` command to run scripts. '#' comments. Instructions are tokenised without sscanf().
+  2026/10/18 - 64-bit integer and double variables. Variable change callbacks, change counting, and value ranges.
+  2026/10/18 - apg_c_draw_to_glyph_instances() to draw console text on the GPU from the pixfont atlas.
+  2026/10/18 - Functions called from the console are timed. `profile` command, and apg_c_set_timer_func().
   
 Instructions
 ============
@@ -47,6 +57,12 @@ Built-in commands include:
   "clear"          - invoke the 'clear' command.
   "list_vars"      - print registered variables and their values to drop-down console
   "list_funcs"     - print registered variables and their values to drop-down console
+  "exec my.cfg"    - run each line of the file 'my.cfg' as an instruction.
+  "profile"        - print call counts and times of registered functions called from the console, slowest in total first.
+
+Anything after a word starting with '#' is a comment, and is ignored.
+Scripts, such as config files, can also be run from memory with apg_c_exec_buffer(). Unlike typed instructions, these lines are not echoed to the
+output or added to the command history.
 
 Variables may also be registered, or accessed programmatically:
 
@@ -63,6 +79,7 @@ Scrolling output text may be interacted with programmatically:
 
   apg_c_output_clear()   - Clear the output text.
   apg_c_print( str )     - Adds a line of text to the output such as a debug message.
+  apg_c_print_mt( str )  - Adds a line of text to the output from any thread.
   apg_c_dump_to_stdout() - Writes the current console output text to stdout via printf().
   apg_c_count_lines()    - Counts the number of lines in the console output.
 
@@ -83,9 +100,9 @@ extern "C" {
 
 #define APG_C_UNUSED( x ) (void)( x ) // to suppress compiler warnings with unused/dummy arguments in callbacks
 #define APG_C_STR_MAX 128             // maximum console string length. commands and variable names must be shorter than this.
-#define APG_C_VARS_MAX 256            // maximum number of variables stored in console
-#define APG_C_FUNCS_MAX 128           // maximum number of console commands
-#define APG_C_OUTPUT_LINES_MAX 32     // maximum number of lines retained in output
+#define APG_C_VARS_MAX 256            // variables are allocated in blocks of this many. there is no limit on the number of variables
+#define APG_C_FUNCS_MAX 128           // initial space for console commands. grows as needed
+#define APG_C_OUTPUT_LINES_MAX 32     // default number of lines retained in output. see apg_c_output_reserve()
 
 /* =======================================================================================================================
 user-entered text API. call these functions based on eg keyboard input.
@@ -94,10 +111,16 @@ user-entered text API. call these functions based on eg keyboard input.
 // RETURNS - true if a valid command was parsed out of str.
 bool apg_c_append_user_entered_text( const char* str );
 
+// Runs every line in the first len bytes of buf as an instruction, without echoing them to the output or adding them to the command history.
+// Errors are printed to the output as usual.
+// RETURNS - true if every line was parsed successfully.
+bool apg_c_exec_buffer( const char* buf, int len );
+
 // removes the last char from the current user-entered string.
 void apg_c_backspace( void );
 
-// autocompletes the current user-entered text if it matches a command. call if i.e. the user presses 'TAB'
+// autocompletes the last word of the current user-entered text if it starts a command, function, or variable name. call if i.e. the user presses 'TAB'
+// if several names match then the text is completed as far as they all agree, and the first few candidates are printed to the output.
 void apg_c_autocomplete( void );
 
 // enters a command from recent history into the current user-entered text field. i.e. if user presses up cursor arrow.
@@ -111,8 +134,29 @@ console output text API.
 ======================================================================================================================= */
 
 void apg_c_output_clear( void );
+
+// Sets how much output is retained, and clears the current output. Lines are stored in one block of max_bytes, using only their length + 1 byte each.
+// When either max_lines or max_bytes is used up the oldest lines are dropped. If not called the default is APG_C_OUTPUT_LINES_MAX lines of up to
+// APG_C_STR_MAX bytes.
+// RETURNS false if either argument is too small or on allocation failure, in which case the previous output is kept.
+bool apg_c_output_reserve( int max_lines, int max_bytes );
+
 // Appends str as an output line to the scrolling output
+// WARNING Call this, and the rest of the console API, only from the thread that owns the console. Other threads should use apg_c_print_mt().
 void apg_c_print( const char* str );
+
+// Thread-safe, lock-free version of apg_c_print() for logging from any thread. The line is copied into a queue of APG_C_PRINT_QUEUE_LEN (256) lines
+// that is moved into the output by apg_c_flush_print_queue(), which is called by apg_c_draw_to_image_mem(), apg_c_image_redraw_required(),
+// apg_c_count_lines(), and apg_c_dump_to_stdout().
+// RETURNS false if the queue was full and the line was dropped. A warning line with the number of lines dropped is printed when the queue is next flushed.
+bool apg_c_print_mt( const char* str );
+
+// Moves lines queued by apg_c_print_mt() into the output. Call from the thread that owns the console.
+void apg_c_flush_print_queue( void );
+
+// RETURNS the total number of lines apg_c_print_mt() has dropped because the queue was full.
+uint32_t apg_c_count_dropped_prints( void );
+
 int apg_c_count_lines( void );
 // printf everything in console to stdout stream
 void apg_c_dump_to_stdout( void );
@@ -121,12 +165,16 @@ void apg_c_dump_to_stdout( void );
 program <-> console variable and function linkage API
 ======================================================================================================================= */
 
-typedef enum apg_c_var_datatype_t { APG_C_BOOL, APG_C_INT32, APG_C_UINT32, APG_C_FLOAT, APG_C_OTHER } apg_c_var_datatype_t;
+typedef enum apg_c_var_datatype_t { APG_C_BOOL, APG_C_INT32, APG_C_UINT32, APG_C_FLOAT, APG_C_OTHER, APG_C_INT64, APG_C_DOUBLE } apg_c_var_datatype_t;
 
 typedef struct apg_c_var_t {
-  char str[APG_C_STR_MAX];
+  const char* str;
   void* var_ptr;
   apg_c_var_datatype_t datatype;
+  void ( *on_change )( const struct apg_c_var_t* var ); // called after the console changes the value. NULL if not set.
+  double min_val, max_val;                              // values set from the console are clamped to this range if has_range is set
+  bool has_range;
+  uint64_t last_change; // value of apg_c_count_var_changes() when the console last changed this variable. 0 if never.
 } apg_c_var_t;
 
 // Registers and existing program variable with the console.
@@ -136,17 +184,38 @@ typedef struct apg_c_var_t {
 //   var_ptr  - Pointer to variable to register and use for this c_var.
 //   datatype - Data type of the variable pointed to by var_ptr. Determines how values can be set from the console.
 // RETURNS
-//   false if failed ie not space left in array of var ptrs.
+//   false if the name is already in use, or on allocation failure.
 bool apg_c_register_var( const char* str, void* var_ptr, apg_c_var_datatype_t datatype );
 
 // Fetches the address of a console variable with name `str`.
 // RETURNS
 //   NULL if the variable does not exist.
-//   Address of the c_var entry with pointer and data type.
+//   Address of the c_var entry with pointer and data type. This stays valid as more variables are registered, until apg_c_free() is called.
 apg_c_var_t* apg_c_get_var( const char* str );
 
+// Sets a function to call whenever the console changes the value of variable `str`, so your program doesn't need to check it every frame.
+// Pass NULL to remove it.
+// RETURNS false if the variable does not exist.
+bool apg_c_set_var_callback( const char* str, void ( *on_change )( const apg_c_var_t* var ) );
+
+// Limits values set from the console for variable `str` to between min_val and max_val inclusive.
+// RETURNS false if the variable does not exist, or min_val > max_val.
+bool apg_c_set_var_range( const char* str, double min_val, double max_val );
+
+// RETURNS the number of times the console has changed any variable's value. Compare this to a previous value to see if anything changed since then,
+// and apg_c_var_t.last_change to see which variables did.
+uint64_t apg_c_count_var_changes( void );
+
 bool apg_c_register_func( const char* str, bool ( *fptr )( const char* arg_str ) );
 
+// Sets the clock used to time functions called from the console, for the `profile` command. e.g. apg_time_s() from apg.h.
+// timer_func should return seconds from a monotonic clock. Pass NULL to use the console's own monotonic clock.
+void apg_c_set_timer_func( double ( *timer_func )( void ) );
+
+// Frees all memory held by the console - registered variables and functions, and output text.
+// The console can be used again afterwards, starting from no registrations and empty output.
+void apg_c_free( void );
+
 /* =======================================================================================================================
 rendering API
 ======================================================================================================================= */
@@ -154,17 +223,37 @@ rendering API
 // Draw the current console text into an image buffer you have allocated with dimensions w, h, and n_channels.
 // The destination image does not need to exactly match the console text size - it can be bigger or smaller.
 // Text starts drawing at the bottom-left of the provided image, and lines scroll upwards.
+// If called again with the same image, dimensions, and background colour only the parts that have changed are redrawn - the prompt line, and any new output
+// lines, with existing output scrolled up in the image. So don't modify the image between calls, or pass in a different pointer if you do.
 // PARAMETERS
 //   img_ptr    - pointer to the destination image bytes. must not be NULL
 //   w,h        - dimensions of the destination image in pixels
-//   n_channels - number of channels in the destination image
+//   n_channels - number of channels in the destination image. 1 to 4
+//   background_colour - n_channels bytes to fill the image with behind the text
 // RETURNS
 //   false on any failure
 bool apg_c_draw_to_image_mem( uint8_t* img_ptr, int w, int h, int n_channels, uint8_t* background_colour );
 
-// RETURNS true if console has changed since last call to apg_c_draw_to_image_mem() and can be painted again
+// RETURNS true if console has changed since last call to apg_c_draw_to_image_mem() or apg_c_draw_to_glyph_instances() and can be painted again
 bool apg_c_image_redraw_required();
 
+// One glyph of console text, as a textured quad to draw with the apg_pixfont atlas image.
+typedef struct apg_c_glyph_instance_t {
+  float x0, y0, x1, y1; // top-left and bottom-right of the quad in pixels, from the top-left of the console area, with y pointing down
+  float u0, v0, u1, v1; // texture coordinates of the glyph in the atlas from apg_pixfont_atlas_into_image()
+  uint8_t rgba[4];      // text colour
+} apg_c_glyph_instance_t;
+
+// Lays out the current console text as one instance per glyph, for drawing on the GPU instead of rasterising an image with apg_c_draw_to_image_mem().
+// Upload the atlas from apg_pixfont_atlas_into_image() once as a texture, and draw the instances on top of your own background, eg in one instanced draw
+// call. Lines are placed the same as apg_c_draw_to_image_mem() would into a w x h image. Text outlines are not generated.
+// PARAMETERS
+//   w,h           - dimensions of the console area in pixels
+//   instances     - array of max_instances to write into. May be NULL if max_instances is 0, to count the instances required.
+// RETURNS
+//   The number of instances needed for all the visible text, which may be more than max_instances - in that case only the first max_instances are written.
+int apg_c_draw_to_glyph_instances( int w, int h, apg_c_glyph_instance_t* instances, int max_instances );
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,4 +7,4 @@ SAN="-fsanitize=address -fsanitize=undefined"
 cp ../apg_pixfont/apg_pixfont.c ./
 cp ../apg_pixfont/apg_pixfont.h ./
 
-$CC $FLAGS $SAN tests/main.c apg_console.c apg_pixfont.c -I ./
+$CC $FLAGS $SAN tests/main.c apg_console.c apg_pixfont.c -I ./ -lm -pthread
@@ -2,20 +2,116 @@
 // Anton Gerdelan 24 Mar 2020
 
 #include "apg_console.h"
+#include "apg_pixfont.h"
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 bool anton_func( const char* arg_str ) {
   printf( "the value given to anton_func was `%s`\n", arg_str );
   return true;
 }
 
+bool quiet_func( const char* arg_str ) {
+  (void)arg_str;
+  return true;
+}
+
+#ifndef _WIN32
+static void* print_thread( void* arg ) {
+  char line[APG_C_STR_MAX];
+  for ( int i = 0; i < 50; i++ ) {
+    snprintf( line, APG_C_STR_MAX, "worker %i line %i", *(int*)arg, i );
+    apg_c_print_mt( line );
+  }
+  return NULL;
+}
+#endif
+
+// a clock that advances 1ms every time it is read, so profiled function times are predictable
+static double fake_time_s;
+double fake_timer( void ) {
+  fake_time_s += 0.001;
+  return fake_time_s;
+}
+
+static int n_change_callbacks;
+void on_var_change( const apg_c_var_t* var ) {
+  n_change_callbacks++;
+  printf( "`%s` changed. change #%llu\n", var->str, (unsigned long long)var->last_change );
+}
+
 int main() {
   int anton_var = 666;
   apg_c_register_var( "anton_var", &anton_var, APG_C_INT32 );
   apg_c_var_t* v_ptr = apg_c_get_var( "anton_var" );
   printf( "var: `%s`. val: %i\n", v_ptr->str, *( (int*)v_ptr->var_ptr ) );
   apg_c_register_func( "anton_func", anton_func );
+  apg_c_register_func( "quiet_func", quiet_func );
+
+  { // lots of variables, as from a config file, should all be found by name. names in use should be rejected.
+    static int many_vars[3000];
+    apg_c_var_t* first_var = apg_c_get_var( "anton_var" );
+    int n_found            = 0;
+    for ( int i = 0; i < 3000; i++ ) {
+      char name[APG_C_STR_MAX];
+      snprintf( name, APG_C_STR_MAX, "cfg_var_%03i", i );
+      many_vars[i] = i;
+      apg_c_register_var( name, &many_vars[i], APG_C_INT32 );
+    }
+    for ( int i = 0; i < 3000; i++ ) {
+      char name[APG_C_STR_MAX];
+      snprintf( name, APG_C_STR_MAX, "cfg_var_%03i", i );
+      apg_c_var_t* var = apg_c_get_var( name );
+      if ( var && *(int*)var->var_ptr == i ) { n_found++; }
+    }
+    printf( "found %i/3000 registered vars. first var pointer %s\n", n_found, first_var == apg_c_get_var( "anton_var" ) ? "unchanged" : "MOVED" );
+    printf( "register duplicate var=%i builtin=%i func=%i\n", apg_c_register_var( "cfg_var_007", &anton_var, APG_C_INT32 ),
+      apg_c_register_var( "help", &anton_var, APG_C_INT32 ), apg_c_register_var( "anton_func", &anton_var, APG_C_INT32 ) );
+    apg_c_append_user_entered_text( "cfg" );
+    apg_c_autocomplete(); // completes the prefix shared by all candidates "cfg_var_", and lists the first few candidates
+    apg_c_append_user_entered_text( "19" );
+    apg_c_autocomplete(); // over 100 candidates - no completion, and only the first few are listed
+    apg_c_append_user_entered_text( "9" );
+    apg_c_autocomplete(); // cfg_var_199 and cfg_var_1990 to cfg_var_1999 - no completion
+    apg_c_append_user_entered_text( "\n" );
+    apg_c_append_user_entered_text( "cfg_var_199 42\n" );
+    printf( "cfg_var_199 set to %i\n", many_vars[199] );
+
+    // typed variables with change notification and ranges
+    int64_t big_var   = 0;
+    double double_var = 0.0;
+    apg_c_register_var( "big_var", &big_var, APG_C_INT64 );
+    apg_c_register_var( "double_var", &double_var, APG_C_DOUBLE );
+    apg_c_set_var_callback( "big_var", on_var_change );
+    apg_c_set_var_callback( "double_var", on_var_change );
+    apg_c_set_var_range( "double_var", -1.0, 1.0 );
+    uint64_t n_changes = apg_c_count_var_changes();
+    apg_c_append_user_entered_text( "big_var 9000000000\n" );
+    apg_c_append_user_entered_text( "big_var 9000000000\n" ); // same value - no change
+    apg_c_append_user_entered_text( "double_var 0.25\n" );
+    apg_c_append_user_entered_text( "double_var 5\n" ); // clamped to 1
+    printf( "big_var=%lld double_var=%f callbacks=%i changes=%llu\n", (long long)big_var, double_var, n_change_callbacks,
+      (unsigned long long)( apg_c_count_var_changes() - n_changes ) );
+
+    // a config script from memory, and one run from a file with `exec`. neither should be echoed to the output.
+    const char* script = "# startup config\n\ncfg_var_000 10 # trailing comment\r\n  cfg_var_001\t11\ncfg_var_002 12";
+    apg_c_output_clear();
+    bool script_ok = apg_c_exec_buffer( script, (int)strlen( script ) );
+    printf( "exec_buffer ok=%i vars=%i %i %i output lines=%i\n", script_ok, many_vars[0], many_vars[1], many_vars[2], apg_c_count_lines() );
+    FILE* f_ptr = fopen( "test_script.cfg", "wb" );
+    if ( f_ptr ) {
+      for ( int i = 0; i < 3000; i++ ) { fprintf( f_ptr, "cfg_var_%03i %i\n", i, 3000 - i ); }
+      fprintf( f_ptr, "not_a_var 1\n" );
+      fclose( f_ptr );
+      printf( "exec file ok=%i", apg_c_append_user_entered_text( "exec test_script.cfg\n" ) ); // fails on the last line
+      printf( " vars=%i %i output lines=%i\n", many_vars[0], many_vars[2999], apg_c_count_lines() );
+      remove( "test_script.cfg" );
+    }
+  }
 
   apg_c_append_user_entered_text( "help\n" );
   apg_c_dump_to_stdout();
@@ -29,6 +125,13 @@ int main() {
   apg_c_dump_to_stdout();
   apg_c_append_user_entered_text( "anton_func\n" );
   apg_c_append_user_entered_text( "anton_func 123.456\n" );
+  // every call measures 1ms with the fake timer. anton_func was also called above with the real clock.
+  apg_c_set_timer_func( fake_timer );
+  for ( int i = 0; i < 3; i++ ) { apg_c_append_user_entered_text( "quiet_func\n" ); }
+  apg_c_set_timer_func( NULL );
+  apg_c_output_clear();
+  apg_c_append_user_entered_text( "profile\n" );
+  apg_c_dump_to_stdout();
   if ( apg_c_image_redraw_required() ) {
     printf( "apg_c_image_redraw_required()=TRUE\n" );
   } else {
@@ -54,6 +157,88 @@ int main() {
   apg_c_append_user_entered_text( "\n" );
   apg_c_dump_to_stdout();
   apg_c_reuse_hist( 1 );
+
+  { // incremental redraws should match drawing everything from scratch into a new image
+    const int tall_h      = 640; // more rows than there are lines in the output history
+    uint8_t* inc_img_ptr  = malloc( w * tall_h * n_channels );
+    uint8_t* full_img_ptr = malloc( w * tall_h * n_channels );
+    apg_c_draw_to_image_mem( inc_img_ptr, w, tall_h, n_channels, background_colour );
+    apg_c_append_user_entered_text( "anton_v" ); // prompt only
+    apg_c_draw_to_image_mem( inc_img_ptr, w, tall_h, n_channels, background_colour );
+    for ( int i = 0; i < 40; i++ ) { // scroll, and eventually drop old lines from the output history
+      apg_c_print( i % 2 ? "odd line" : "even line" );
+      if ( i % 7 == 0 ) { apg_c_draw_to_image_mem( inc_img_ptr, w, tall_h, n_channels, background_colour ); }
+    }
+    apg_c_draw_to_image_mem( inc_img_ptr, w, tall_h, n_channels, background_colour );
+    apg_c_draw_to_image_mem( full_img_ptr, w, tall_h, n_channels, background_colour );
+    printf( "incremental redraw %s full redraw\n", 0 == memcmp( inc_img_ptr, full_img_ptr, w * tall_h * n_channels ) ? "matches" : "DOES NOT MATCH" );
+    int n_black_px = 0; // text outlines are black, and should not be replaced by the background colour
+    for ( int i = 0; i < w * tall_h; i++ ) { n_black_px += 0 == full_img_ptr[i * n_channels] && 0 == full_img_ptr[i * n_channels + 1] && 0 == full_img_ptr[i * n_channels + 2]; }
+    printf( "black outline pixels drawn = %i\n", n_black_px );
+
+    // glyph instances should land on the same pixels as the text in the image
+    int n_instances                   = apg_c_draw_to_glyph_instances( w, tall_h, NULL, 0 );
+    apg_c_glyph_instance_t* instances = malloc( n_instances * sizeof( apg_c_glyph_instance_t ) );
+    unsigned char atlas[APG_PIXFONT_ATLAS_W * APG_PIXFONT_ATLAS_H];
+    apg_pixfont_atlas_into_image( atlas );
+    apg_c_draw_to_glyph_instances( w, tall_h, instances, n_instances );
+    int n_text_px = 0, n_mismatched_px = 0;
+    for ( int i = 0; i < n_instances; i++ ) {
+      const apg_c_glyph_instance_t* g = &instances[i];
+      for ( int y = (int)g->y0; y < (int)g->y1; y++ ) {
+        for ( int x = (int)g->x0; x < (int)g->x1 && x < w; x++ ) {
+          int u = (int)( g->u0 * APG_PIXFONT_ATLAS_W + 0.5f ) + x - (int)g->x0;
+          int v = y - (int)g->y0;
+          if ( !atlas[v * APG_PIXFONT_ATLAS_W + u] ) { continue; }
+          n_text_px++;
+          if ( full_img_ptr[( y * w + x ) * n_channels] != 0xFF || full_img_ptr[( y * w + x ) * n_channels + 2] != 0xFF ) { n_mismatched_px++; }
+        }
+      }
+    }
+    printf( "glyph instances = %i. text pixels = %i, mismatched = %i\n", n_instances, n_text_px, n_mismatched_px );
+    free( instances );
+
+    // a long history of lines, limited by bytes rather than line count, drops several short lines to fit a long one
+    apg_c_output_reserve( 10000, 1000 );
+    apg_c_draw_to_image_mem( inc_img_ptr, w, tall_h, n_channels, background_colour );
+    for ( int i = 0; i < 200; i++ ) {
+      char line[APG_C_STR_MAX];
+      snprintf( line, APG_C_STR_MAX, "%i%*s", i, i % 3 ? 1 : 90, "!" );
+      apg_c_print( line );
+      if ( i % 5 == 0 ) { apg_c_draw_to_image_mem( inc_img_ptr, w, tall_h, n_channels, background_colour ); }
+    }
+    apg_c_draw_to_image_mem( inc_img_ptr, w, tall_h, n_channels, background_colour );
+    apg_c_draw_to_image_mem( full_img_ptr, w, tall_h, n_channels, background_colour );
+    printf( "lines kept in 1000 bytes = %i. incremental redraw %s full redraw\n", apg_c_count_lines(),
+      0 == memcmp( inc_img_ptr, full_img_ptr, w * tall_h * n_channels ) ? "matches" : "DOES NOT MATCH" );
+    apg_c_output_reserve( 10000, 100 ); // fill the image with short lines, then drop most of them for one long one
+    for ( int i = 0; i < 50; i++ ) { apg_c_print( "x" ); }
+    apg_c_draw_to_image_mem( inc_img_ptr, w, tall_h, n_channels, background_colour );
+    apg_c_print( "a long line that needs the space of most of the short lines......................................" );
+    apg_c_draw_to_image_mem( inc_img_ptr, w, tall_h, n_channels, background_colour );
+    apg_c_draw_to_image_mem( full_img_ptr, w, tall_h, n_channels, background_colour );
+    printf( "lines kept in 100 bytes = %i. incremental redraw %s full redraw\n", apg_c_count_lines(),
+      0 == memcmp( inc_img_ptr, full_img_ptr, w * tall_h * n_channels ) ? "matches" : "DOES NOT MATCH" );
+    free( inc_img_ptr );
+    free( full_img_ptr );
+  }
   free( img_ptr );
+
+#ifndef _WIN32
+  { // several threads logging at once. fewer lines than the queue holds, so none should be dropped even without flushing.
+    apg_c_output_reserve( 1000, 1000 * 32 );
+    pthread_t threads[4];
+    int thread_ids[4] = { 0, 1, 2, 3 };
+    for ( int i = 0; i < 4; i++ ) { pthread_create( &threads[i], NULL, print_thread, &thread_ids[i] ); }
+    for ( int i = 0; i < 4; i++ ) { pthread_join( threads[i], NULL ); }
+    printf( "threaded prints: %i lines, %u dropped\n", apg_c_count_lines(), apg_c_count_dropped_prints() );
+  }
+#endif
+  { // overflow the queue. the extra lines are dropped, with one warning line.
+    apg_c_output_clear();
+    for ( int i = 0; i < 300; i++ ) { apg_c_print_mt( "queued line" ); }
+    printf( "overflowed print queue: %i lines, %u dropped\n", apg_c_count_lines(), apg_c_count_dropped_prints() );
+  }
+  apg_c_free();
   return 0;
 }
@@ -1,14 +1,31 @@
-/* apg_pixfont - C Pixel Font Utility v0.0.5
+/* apg_pixfont - C Pixel Font Utility v0.1.3
 C99 Implementation
 See header file for licence and instructions.
 Anton Gerdelan 2019
 ============================================================== */
 #include "apg_pixfont.h"
 #include <assert.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define _APG_PIXFONT_SSE2
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define _APG_PIXFONT_NEON
+#endif
+#ifndef APG_PIXFONT_NO_THREADS
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#endif
 
 // clang-format off
 static const int _font_img_w = 800;
@@ -16,6 +33,46 @@ static const int _font_img_h = 16;
 static const unsigned char _font_img[] = { 0,0,0,0,0,0,255,255,0,255,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,0,255,0,0,0,0,255,0,255,0,0,0,0,255,0,0,0,0,255,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,255,255,255,0,0,0,0,255,0,0,0,0,255,255,255,0,0,0,255,255,255,0,0,0,0,255,255,0,0,255,255,255,255,255,0,0,255,255,255,0,0,255,255,255,255,255,0,0,255,255,255,0,0,0,255,255,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,255,255,0,0,0,255,255,255,0,0,0,255,255,255,0,0,255,255,255,255,0,0,0,255,255,255,0,0,255,255,255,255,0,0,255,255,255,255,255,0,255,255,255,255,255,0,0,255,255,255,255,0,255,0,0,0,255,0,255,255,255,255,255,0,255,255,255,255,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,255,255,255,0,0,255,255,255,255,0,0,0,255,255,255,0,0,255,255,255,255,0,0,0,255,255,255,0,0,255,255,255,255,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,255,255,255,255,0,255,255,255,0,0,0,255,0,0,0,0,0,255,255,255,0,0,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,255,255,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,255,255,255,0,0,0,255,255,255,0,0,0,255,255,255,255,0,0,255,255,255,0,0,255,255,255,255,255,0,255,255,255,255,255,0,255,255,255,255,255,0,255,255,255,255,255,0,0,255,255,255,0,0,0,255,255,255,0,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,255,255,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,255,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,255,255,255,0,0,0,0,0,0,0,0,255,0,255,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,255,255,0,0,255,0,0,255,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,255,0,255,0,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,0,0,0,255,0,0,255,0,0,255,0,0,255,0,0,0,0,0,255,255,0,255,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,255,0,255,0,0,255,0,0,0,255,0,0,0,0,0,255,0,255,0,0,0,0,0,0,255,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,255,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,255,0,0,0,0,255,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,255,0,0,0,255,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,255,0,255,0,0,0,255,0,0,0,0,0,255,0,255,0,0,0,0,255,0,0,0,0,255,0,255,0,0,0,0,255,0,0,0,255,0,0,0,0,0,0,255,0,255,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,255,0,255,0,0,255,0,255,0,255,0,0,0,0,0,255,0,255,0,255,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,255,255,0,0,255,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,255,0,0,0,255,0,255,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,255,0,0,255,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,0,0,0,0,0,255,0,0,255,0,0,255,0,0,255,0,0,0,0,0,255,0,255,0,255,0,255,255,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,255,0,0,0,0,0,0,255,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,255,0,0,0,255,255,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,255,0,0,0,0,255,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,255,255,255,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,255,0,255,0,0,255,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,255,255,255,255,255,0,255,0,255,0,0,0,255,0,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,255,255,255,255,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,255,0,0,0,255,0,0,0,0,0,0,255,0,0,0,0,255,0,0,0,255,0,0,255,0,0,0,255,255,255,0,0,255,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,255,255,255,255,255,0,0,0,0,255,0,0,0,0,0,255,0,0,255,0,255,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,0,0,0,0,0,255,0,0,255,255,255,0,0,0,255,0,0,0,0,0,255,0,255,0,255,0,255,0,255,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,255,255,255,0,255,255,255,255,0,0,0,255,255,255,255,0,0,255,255,255,255,0,0,255,255,255,0,0,255,255,255,255,0,0,0,255,255,255,255,0,255,255,255,255,0,0,255,255,255,0,0,0,0,255,255,255,255,0,0,255,0,0,255,0,255,0,0,0,0,0,255,255,0,255,0,0,255,255,255,255,0,0,0,255,255,255,0,0,255,255,255,255,0,0,0,255,255,255,255,0,255,0,255,255,0,0,0,255,255,255,0,0,255,255,255,255,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,255,255,255,255,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,255,0,0,255,0,0,255,255,255,255,255,0,255,255,255,255,255,0,255,255,255,255,0,0,255,255,255,0,255,0,255,255,255,0,0,0,255,255,255,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,0,255,255,255,255,0,0,255,255,255,255,0,0,255,255,255,0,0,0,255,255,255,255,0,0,255,255,255,0,0,0,255,255,255,0,0,255,255,255,0,0,0,255,255,255,0,0,0,0,255,255,255,0,0,0,255,255,255,0,0,255,0,255,255,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,255,255,255,0,0,0,0,255,0,0,0,255,0,255,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,255,255,255,255,0,0,0,0,0,0,0,255,255,255,255,255,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,255,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,255,0,0,255,0,0,255,0,0,0,0,0,0,255,0,255,255,255,255,0,0,0,0,0,255,0,0,0,255,255,255,0,0,0,255,255,255,255,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,0,255,0,0,255,255,255,255,255,0,255,255,255,255,0,0,255,0,0,0,0,0,255,0,0,0,255,0,255,255,255,0,0,0,255,255,255,0,0,0,255,0,0,255,255,0,255,255,255,255,255,0,0,0,255,0,0,0,0,0,0,255,0,0,255,255,255,0,0,0,255,0,0,0,0,0,255,0,255,0,255,0,255,0,255,0,255,0,255,0,0,0,255,0,255,255,255,255,0,0,255,0,0,0,255,0,255,255,255,255,0,0,0,255,255,255,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,255,0,255,0,0,0,255,0,0,0,0,0,255,0,0,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,255,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,0,0,0,0,255,0,0,255,255,255,0,0,255,0,0,0,0,0,255,0,255,0,255,0,0,255,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,255,0,0,255,255,0,0,255,0,255,0,0,0,0,0,0,255,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,255,0,255,0,0,255,0,0,0,255,0,0,0,0,0,255,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,255,0,0,0,0,255,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,255,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,255,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,255,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,255,255,255,255,255,0,0,0,255,0,255,0,0,255,0,0,255,0,255,0,255,0,255,0,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,255,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,255,0,0,255,255,0,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,255,0,255,255,255,255,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,0,255,0,0,255,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,255,255,255,255,255,0,0,0,0,255,0,0,0,0,255,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,255,0,0,255,0,0,255,0,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,255,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,255,0,255,0,255,0,0,255,0,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,255,0,255,0,0,255,0,255,0,0,0,0,255,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,255,0,255,255,255,255,255,0,0,255,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,0,0,0,0,255,0,0,255,255,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,255,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,255,0,0,255,0,0,0,0,0,0,255,255,255,0,0,0,255,0,0,0,0,255,0,0,0,255,0,0,255,0,255,0,0,255,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,255,255,255,0,0,0,0,255,0,0,0,255,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,255,0,0,0,0,255,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,255,255,255,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,255,255,255,255,0,255,0,0,0,255,0,255,255,255,255,255,0,255,255,255,255,255,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,255,0,0,255,0,255,0,255,0,255,0,0,0,0,0,255,0,0,255,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,255,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,255,0,0,0,0,0,255,0,0,0,0,255,0,0,255,255,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,0,255,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,255,0,0,255,0,0,255,0,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,255,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,255,0,255,0,0,255,0,255,0,255,0,0,255,0,255,0,0,0,0,255,0,0,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,0,255,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,255,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,0,0,0,255,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,0,0,0,0,255,0,0,255,0,255,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,255,0,0,255,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,255,0,0,255,0,0,0,0,0,0,0,0,0,255,0,0,255,0,0,255,0,255,0,0,255,255,0,0,255,0,255,0,0,255,0,255,0,255,0,0,255,0,255,0,0,255,0,0,0,255,0,255,0,0,0,0,0,0,0,255,0,0,0,255,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,255,0,0,0,0,255,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,255,255,0,255,0,0,255,255,0,255,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,0,0,255,0,0,0,0,0,0,0,255,0,0,0,0,0,255,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,255,0,0,255,0,255,0,0,255,255,0,255,0,0,255,255,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,255,0,255,0,0,0,255,255,255,0,0,0,0,0,0,0,0,0,255,255,0,255,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,255,255,0,0,0,0,255,0,0,0,0,0,0,255,255,255,0,0,255,255,255,255,255,0,255,255,255,255,255,0,0,255,255,255,0,0,0,0,255,255,255,0,0,255,255,255,0,0,0,255,255,255,0,0,0,0,255,0,0,0,0,255,255,255,0,0,0,255,255,0,0,0,255,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,255,255,255,0,0,255,0,0,0,255,0,255,255,255,255,0,0,0,255,255,255,0,0,255,255,255,255,0,0,255,255,255,255,255,0,255,0,0,0,0,0,0,255,255,255,0,0,255,0,0,0,255,0,255,255,255,255,255,0,0,255,255,0,0,0,255,0,0,0,255,0,255,255,255,255,255,0,255,0,0,0,255,0,255,0,0,0,255,0,0,255,255,255,0,0,255,0,0,0,0,0,0,255,255,255,0,0,255,0,0,0,255,0,0,255,255,255,0,0,0,0,255,0,0,0,0,255,255,255,0,0,0,0,255,0,0,0,0,255,0,255,0,0,255,0,0,0,255,0,0,0,255,0,0,0,255,255,255,255,255,0,255,255,255,0,0,0,0,0,0,0,255,0,255,255,255,0,0,0,0,0,0,0,0,0,255,255,255,255,255,0,0,0,0,0,0,0,0,255,255,0,255,0,255,255,255,255,0,0,0,255,255,255,255,0,0,255,255,255,255,0,0,255,255,255,255,0,0,255,0,0,0,0,0,255,255,255,255,0,255,0,0,0,255,0,255,255,255,255,255,0,0,0,0,0,255,0,0,255,0,0,255,0,255,0,0,0,0,0,255,0,0,0,255,0,0,255,0,0,255,0,0,255,255,255,0,0,255,255,255,255,0,0,0,255,255,255,0,0,255,0,0,0,0,0,0,255,255,255,0,0,0,0,255,255,0,0,0,255,255,0,255,0,0,0,255,0,0,0,0,255,0,255,0,0,255,0,0,0,255,0,0,255,255,255,255,0,255,255,255,255,255,0,0,0,0,255,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,255,0,0,0,255,0,255,0,255,255,255,0,0,255,255,255,0,0,255,255,255,255,255,0,255,255,255,255,255,0,255,255,255,255,255,0,255,255,255,255,255,0,0,255,255,255,0,0,0,255,255,255,0,0,255,0,0,0,0,0,0,255,255,255,0,0,0,255,255,255,0,0,0,0,255,0,0,0,255,0,255,255,0,0,0,255,255,0,255,0,0,255,255,0,255,0,255,0,255,255,255,0,0,255,255,255,255,0,0,255,255,255,255,0,0,255,255,255,255,0,255,255,255,255,255,0,255,255,255,255,255,0,0,255,255,255,0,0,0,255,255,255,0,0,255,0,255,255,0,0,0,255,255,0,255,0,0,255,255,0,255,0,0,255,255,255,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,255,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,255,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,255,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,255,255,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 };
 // clang-format on
 
+#define _APG_PIXFONT_GLYPH_W 6                                       // width of each glyph's cell in the atlas image
+#define _APG_PIXFONT_N_GLYPHS ( 800 / _APG_PIXFONT_GLYPH_W )         // glyphs in the atlas image
+#define _APG_PIXFONT_SPAN_PX 64                                      // pixels of text colour filled in advance for copying runs from
+
+/* Each glyph pre-rasterised into one bitmask per atlas row. Bit x is set if column x of the glyph is coloured. */
+static uint8_t _glyph_rows[_APG_PIXFONT_N_GLYPHS][16];
+
+/* The runs of consecutive set bits in every possible 6-bit glyph row, so a row can be drawn with one copy per run. */
+typedef struct _mask_runs_t {
+  uint8_t n;
+  uint8_t start[3], len[3]; // 6 bits can hold at most 3 separate runs
+} _mask_runs_t;
+static _mask_runs_t _mask_runs[1 << _APG_PIXFONT_GLYPH_W];
+
+static void _build_glyph_rows( void ) {
+  for ( int g = 0; g < _APG_PIXFONT_N_GLYPHS; g++ ) {
+    for ( int y = 0; y < _font_img_h; y++ ) {
+      uint8_t mask = 0;
+      for ( int x = 0; x < _APG_PIXFONT_GLYPH_W; x++ ) {
+        if ( _font_img[_font_img_w * y + g * _APG_PIXFONT_GLYPH_W + x] > 0x00 ) { mask |= (uint8_t)( 1 << x ); }
+      }
+      _glyph_rows[g][y] = mask;
+    }
+  }
+  for ( int mask = 0; mask < ( 1 << _APG_PIXFONT_GLYPH_W ); mask++ ) {
+    _mask_runs_t runs = { 0 };
+    for ( int x = 0; x < _APG_PIXFONT_GLYPH_W; x++ ) {
+      if ( !( mask & ( 1 << x ) ) ) { continue; }
+      if ( x > 0 && ( mask & ( 1 << ( x - 1 ) ) ) ) {
+        runs.len[runs.n - 1]++;
+        continue;
+      }
+      runs.start[runs.n] = (uint8_t)x;
+      runs.len[runs.n]   = 1;
+      runs.n++;
+    }
+    _mask_runs[mask] = runs;
+  }
+}
+
 // because string.h doesn't always have strnlen()
 static int _apg_pixfont_strnlen( const char* str, int maxlen ) {
   int i = 0;
@@ -23,64 +80,61 @@ static int _apg_pixfont_strnlen( const char* str, int maxlen ) {
   return i;
 }
 
-// TODO(Anton) replace with unicode codepoint scans and then a lookup table for supported unicode
-// does not handle spacing for ' ' or '\n' - those must be handled before calling this function
-// additional_bytes_processed - if 2+ bytes formed a single glyph then additional_bytes_processed == 1+
-static uint32_t _atlas_index_for_sequence( const char* sequence, int* additional_bytes_processed ) {
-  assert( sequence && additional_bytes_processed );
-
-  int len              = _apg_pixfont_strnlen( sequence, APG_PIXFONT_MAX_STRLEN );
-  uint32_t atlas_index = '?';
-
-  *additional_bytes_processed = 0;
-
-  uint8_t first_byte = (uint8_t)sequence[0];
-
-  if ( first_byte >= ' ' && first_byte <= '~' ) { return (uint32_t)first_byte; } // printable ascii, excluding LF CR TAB
-
-  if ( 0xC3 == first_byte && len > 1 ) {
-    uint8_t second_byte = (uint8_t)sequence[1];
-    // clang-format off
-    switch( second_byte ) {
-      case 0x84: { atlas_index = '~' + 1; } break; // big A umlaut
-      case 0x81: { atlas_index = '~' + 2; } break; // big A acute
-      case 0x86: { atlas_index = '~' + 3; } break; // big Ash (AE)
-      case 0x90: { atlas_index = '~' + 4; } break; // big Eth (-D)
-      case 0x8B: { atlas_index = '~' + 5; } break; // big E umlaut
-      case 0x89: { atlas_index = '~' + 6; } break; // big E acute
-      case 0x8F: { atlas_index = '~' + 7; } break; // big I umlaut
-      case 0x8D: { atlas_index = '~' + 8; } break; // big I acute
-      case 0x96: { atlas_index = '~' + 9; } break; // big O umlaut
-      case 0x93: { atlas_index = '~' + 10; } break; // big O acute
-      case 0x9E: { atlas_index = '~' + 11; } break; // big Thorn (|D)
-      case 0x9C: { atlas_index = '~' + 12; } break; // big U umlaut
-      case 0x9A: { atlas_index = '~' + 13; } break; // big U acute
-      case 0x9D: { atlas_index = '~' + 14; } break; // big Y acute
-      case 0x9F: { atlas_index = '~' + 15; } break; // small doppel S
-      case 0xA4: { atlas_index = '~' + 16; } break; // small a umlaut
-      case 0xA1: { atlas_index = '~' + 17; } break; // small a acute
-      case 0xA6: { atlas_index = '~' + 18; } break; // small ae umlaut
-      case 0xB0: { atlas_index = '~' + 19; } break; // small eth (-d)
-      case 0xAB: { atlas_index = '~' + 20; } break; // small e umlaut
-      case 0xA9: { atlas_index = '~' + 21; } break; // small e acute
-      case 0xAF: { atlas_index = '~' + 22; } break; // small i umlaut
-      case 0xAD: { atlas_index = '~' + 23; } break; // small i acute
-      case 0xB6: { atlas_index = '~' + 24; } break; // small o umlaut
-      case 0xB3: { atlas_index = '~' + 25; } break; // small o acute
-      case 0xBE: { atlas_index = '~' + 26; } break; // small thorn (|d)
-      case 0xBC: { atlas_index = '~' + 27; } break; // small u umlaut
-      case 0xBA: { atlas_index = '~' + 28; } break; // small u acute
-      case 0xBD: { atlas_index = '~' + 29; } break; // small y acute
-      default: atlas_index = '?'; break;
-    }
-    // clang-format on
-    *additional_bytes_processed = 1; // already handled next byte
-  }
-
-  return atlas_index;
-}
-
-static int _get_spacing_for_codepoint( uint32_t codepoint ) {
+/* Runs of consecutive codepoints that have glyphs in the atlas, in atlas order. To support a new range (Greek, Cyrillic, box drawing...) append its glyphs to the
+atlas image and add a run here. */
+typedef struct _glyph_run_t {
+  uint32_t first_codepoint;
+  uint16_t first_glyph, n_glyphs;
+} _glyph_run_t;
+// clang-format off
+static const _glyph_run_t _glyph_runs[] = {
+  { 0x21,  0, 94 }, // printable ASCII '!' to '~'
+  { 0xC4, 94, 1 },  // big A umlaut
+  { 0xC1, 95, 1 },  // big A acute
+  { 0xC6, 96, 1 },  // big Ash (AE)
+  { 0xD0, 97, 1 },  // big Eth (-D)
+  { 0xCB, 98, 1 },  // big E umlaut
+  { 0xC9, 99, 1 },  // big E acute
+  { 0xCF, 100, 1 }, // big I umlaut
+  { 0xCD, 101, 1 }, // big I acute
+  { 0xD6, 102, 1 }, // big O umlaut
+  { 0xD3, 103, 1 }, // big O acute
+  { 0xDE, 104, 1 }, // big Thorn (|D)
+  { 0xDC, 105, 1 }, // big U umlaut
+  { 0xDA, 106, 1 }, // big U acute
+  { 0xDD, 107, 1 }, // big Y acute
+  { 0xDF, 108, 1 }, // small doppel S
+  { 0xE4, 109, 1 }, // small a umlaut
+  { 0xE1, 110, 1 }, // small a acute
+  { 0xE6, 111, 1 }, // small ae
+  { 0xF0, 112, 1 }, // small eth (-d)
+  { 0xEB, 113, 1 }, // small e umlaut
+  { 0xE9, 114, 1 }, // small e acute
+  { 0xEF, 115, 1 }, // small i umlaut
+  { 0xED, 116, 1 }, // small i acute
+  { 0xF6, 117, 1 }, // small o umlaut
+  { 0xF3, 118, 1 }, // small o acute
+  { 0xFE, 119, 1 }, // small thorn (|d)
+  { 0xFC, 120, 1 }, // small u umlaut
+  { 0xFA, 121, 1 }, // small u acute
+  { 0xFD, 122, 1 }, // small y acute
+};
+// clang-format on
+
+#define _APG_PIXFONT_MAX_CODEPOINT 0x10FFFF
+#define _APG_PIXFONT_MAX_PAGES 16 // 256-codepoint pages that may contain glyphs. Page 0 is reserved for 'no glyphs'.
+#define _APG_PIXFONT_NO_GLYPH 0xFF
+#define _APG_PIXFONT_GLYPH_SPACE -1   // not in the atlas, just advances the cursor
+#define _APG_PIXFONT_GLYPH_NEWLINE -2 // not in the atlas, starts a new line
+
+/* Two-level codepoint->glyph table. The top bits of a codepoint pick a page and the low 8 bits index into it. Pages without any glyphs share page 0. */
+static uint8_t _cp_page_of[( _APG_PIXFONT_MAX_CODEPOINT >> 8 ) + 1];
+static uint8_t _cp_pages[_APG_PIXFONT_MAX_PAGES][256];
+static uint8_t _glyph_advance[_APG_PIXFONT_N_GLYPHS]; // pixels the cursor moves after each glyph, before thickness scaling
+static uint32_t _glyph_codepoint[_APG_PIXFONT_N_GLYPHS]; // codepoint each glyph draws
+static int _glyph_unknown;                               // glyph drawn for any codepoint not in the table
+
+static int _advance_for_codepoint( uint32_t codepoint ) {
   if ( 'l' == codepoint || '!' == codepoint || '\'' == codepoint || '|' == codepoint || ':' == codepoint ) { return 2; }
   if ( ',' == codepoint || '.' == codepoint || '`' == codepoint || ';' == codepoint ) { return 3; }
   if ( '(' == codepoint || ')' == codepoint ) { return 4; }
@@ -88,63 +142,413 @@ static int _get_spacing_for_codepoint( uint32_t codepoint ) {
   return 6;
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-int apg_pixfont_image_size_for_str( const char* ascii_str, int* w, int* h, int thickness, int add_outline ) {
-  if ( !ascii_str || !w || !h || thickness < 1 ) { return APG_PIXFONT_FAILURE; }
+static void _build_codepoint_table( void ) {
+  int n_pages = 1, n_glyphs = 0;
+  memset( _cp_pages, _APG_PIXFONT_NO_GLYPH, sizeof( _cp_pages ) );
+  for ( int r = 0; r < (int)( sizeof( _glyph_runs ) / sizeof( _glyph_runs[0] ) ); r++ ) {
+    for ( int i = 0; i < _glyph_runs[r].n_glyphs; i++ ) {
+      uint32_t cp = _glyph_runs[r].first_codepoint + i;
+      int glyph   = _glyph_runs[r].first_glyph + i;
+      assert( glyph < _APG_PIXFONT_N_GLYPHS && cp <= _APG_PIXFONT_MAX_CODEPOINT );
+      if ( 0 == _cp_page_of[cp >> 8] ) {
+        assert( n_pages < _APG_PIXFONT_MAX_PAGES );
+        _cp_page_of[cp >> 8] = (uint8_t)n_pages++;
+      }
+      _cp_pages[_cp_page_of[cp >> 8]][cp & 0xFF] = (uint8_t)glyph;
+      _glyph_advance[glyph]                      = (uint8_t)_advance_for_codepoint( cp );
+      _glyph_codepoint[glyph]                    = cp;
+      n_glyphs++;
+    }
+  }
+  _glyph_unknown = _cp_pages[_cp_page_of['?' >> 8]]['?' & 0xFF];
+  assert( n_glyphs == APG_PIXFONT_N_GLYPHS && "APG_PIXFONT_N_GLYPHS must match the glyph runs" );
+  (void)n_glyphs;
+}
 
-  *w = *h = 0;
+/* Decodes one UTF-8 sequence starting at str[*i] and moves *i past it. Malformed or truncated sequences consume 1 byte and decode as U+FFFD. */
+static uint32_t _decode_utf8( const char* str, int len, int* i ) {
+  const uint8_t* s = (const uint8_t*)&str[*i];
+  int remaining    = len - *i;
+  uint32_t cp      = s[0];
+  int n_bytes      = 1;
+  uint32_t min_cp  = 0;
 
-  int len = _apg_pixfont_strnlen( ascii_str, APG_PIXFONT_MAX_STRLEN );
-  if ( 0 == len ) { return APG_PIXFONT_FAILURE; }
+  if ( cp < 0x80 ) {
+    *i += 1;
+    return cp;
+  } else if ( ( cp & 0xE0 ) == 0xC0 ) {
+    n_bytes = 2;
+    cp &= 0x1F;
+    min_cp = 0x80;
+  } else if ( ( cp & 0xF0 ) == 0xE0 ) {
+    n_bytes = 3;
+    cp &= 0x0F;
+    min_cp = 0x800;
+  } else if ( ( cp & 0xF8 ) == 0xF0 ) {
+    n_bytes = 4;
+    cp &= 0x07;
+    min_cp = 0x10000;
+  } else {
+    *i += 1;
+    return 0xFFFD;
+  }
+  if ( n_bytes > remaining ) {
+    *i += 1;
+    return 0xFFFD;
+  }
+  for ( int b = 1; b < n_bytes; b++ ) {
+    if ( ( s[b] & 0xC0 ) != 0x80 ) {
+      *i += 1;
+      return 0xFFFD;
+    }
+    cp = ( cp << 6 ) | ( s[b] & 0x3F );
+  }
+  if ( cp < min_cp || cp > _APG_PIXFONT_MAX_CODEPOINT || ( cp >= 0xD800 && cp <= 0xDFFF ) ) {
+    *i += 1;
+    return 0xFFFD;
+  }
+  *i += n_bytes;
+  return cp;
+}
+
+/* Decodes the next character of str at str[*i], moves *i past it, and returns its glyph index, _APG_PIXFONT_GLYPH_SPACE, or _APG_PIXFONT_GLYPH_NEWLINE.
+Codepoints without a glyph map to '?'. */
+static int _next_glyph( const char* str, int len, int* i ) {
+  uint32_t cp = _decode_utf8( str, len, i );
+  if ( '\n' == cp ) { return _APG_PIXFONT_GLYPH_NEWLINE; }
+  if ( ' ' == cp ) { return _APG_PIXFONT_GLYPH_SPACE; }
+  if ( cp > _APG_PIXFONT_MAX_CODEPOINT ) { return _glyph_unknown; }
+  uint8_t glyph = _cp_pages[_cp_page_of[cp >> 8]][cp & 0xFF];
+  return _APG_PIXFONT_NO_GLYPH == glyph ? _glyph_unknown : glyph;
+}
+
+static void _build_tables( void ) {
+  _build_glyph_rows();
+  _build_codepoint_table();
+}
+
+#ifndef APG_PIXFONT_NO_THREADS
+#ifdef _WIN32
+static INIT_ONCE _tables_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK _build_tables_once( PINIT_ONCE once, PVOID param, PVOID* context ) {
+  (void)once;
+  (void)param;
+  (void)context;
+  _build_tables();
+  return TRUE;
+}
+#else
+static pthread_once_t _tables_once = PTHREAD_ONCE_INIT;
+#endif
+#else
+static bool _tables_built;
+#endif
+
+/* Builds the glyph bitmasks and codepoint table on first use.
+Safe to call from several threads at once: racing callers wait until the first has finished building. With APG_PIXFONT_NO_THREADS it is a plain flag check. */
+static void _init_tables( void ) {
+#ifndef APG_PIXFONT_NO_THREADS
+#ifdef _WIN32
+  InitOnceExecuteOnce( &_tables_once, _build_tables_once, NULL, NULL );
+#else
+  pthread_once( &_tables_once, _build_tables );
+#endif
+#else
+  if ( _tables_built ) { return; }
+  _build_tables();
+  _tables_built = true;
+#endif
+}
+
+/* Position of one drawn glyph within a layout, in image pixels (already scaled by thickness), relative to the layout's top-left. */
+typedef struct _glyph_pos_t {
+  int x, y;
+  int glyph;
+} _glyph_pos_t;
 
-  int x_cursor = 0, y_cursor = 0, max_x = 0;
+struct apg_pixfont_layout_t {
+  int w, h; // image size the text needs, including thickness and outline
+  int thickness, add_outline;
+  int n_glyphs;
+  _glyph_pos_t glyphs[]; // n_glyphs entries, allocated along with the struct
+};
 
-  for ( int i = 0; i < len; i++ ) {
-    if ( '\n' == ascii_str[i] ) {
+/* Decodes str once and lays out its glyphs. Writes each glyph's position into glyphs, if not NULL, which must have space for len entries.
+RETURNS the number of glyphs placed. */
+static int _layout_str( const char* str, int len, int thickness, int add_outline, _glyph_pos_t* glyphs, int* w, int* h ) {
+  int x_cursor = 0, y_cursor = 0, max_x = 0, n_glyphs = 0;
+
+  for ( int i = 0; i < len; ) {
+    int glyph = _next_glyph( str, len, &i );
+    if ( _APG_PIXFONT_GLYPH_NEWLINE == glyph ) {
       y_cursor += _font_img_h;
       x_cursor = 0;
       continue;
     }
-    if ( ' ' == ascii_str[i] || '\n' == ascii_str[i] ) {
+    if ( _APG_PIXFONT_GLYPH_SPACE == glyph ) {
       x_cursor += 5; // leave a gap
-      max_x = x_cursor > max_x ? x_cursor : max_x;
-      continue;
+    } else {
+      if ( glyphs ) { glyphs[n_glyphs] = ( _glyph_pos_t ){ .x = x_cursor * thickness, .y = y_cursor * thickness, .glyph = glyph }; }
+      n_glyphs++;
+      x_cursor += _glyph_advance[glyph];
     }
-    int additional_i     = 0;
-    uint32_t atlas_index = _atlas_index_for_sequence( &ascii_str[i], &additional_i );
-    i += additional_i;
-    x_cursor += _get_spacing_for_codepoint( atlas_index );
     max_x = x_cursor > max_x ? x_cursor : max_x;
   } // endfor chars in str
-  ;
-  *w = max_x;                  // each char is 6px wide + 1 spacing px
-  *h = _font_img_h + y_cursor; // only 1 row of text supported for now
-
-  *w = *w * thickness;
-  *h = *h * thickness;
 
+  *w = max_x * thickness;
+  *h = ( _font_img_h + y_cursor ) * thickness;
   if ( add_outline ) {
     *w = *w + 1;
     *h = *h + 1;
   }
+  return n_glyphs;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int apg_pixfont_image_size_for_str( const char* ascii_str, int* w, int* h, int thickness, int add_outline ) {
+  if ( !ascii_str || !w || !h || thickness < 1 ) { return APG_PIXFONT_FAILURE; }
+
+  *w = *h = 0;
+
+  _init_tables();
+
+  int len = _apg_pixfont_strnlen( ascii_str, APG_PIXFONT_MAX_STRLEN );
+  if ( 0 == len ) { return APG_PIXFONT_FAILURE; }
+
+  _layout_str( ascii_str, len, thickness, add_outline, NULL, w, h );
 
   return APG_PIXFONT_SUCCESS;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-static bool _is_img_idx_coloured( const unsigned char* image, int idx, int n_channels ) {
-  if ( 1 == n_channels && image[idx] ) { return true; }
-  if ( 2 == n_channels && image[idx + 1] ) { return true; }
-  if ( 3 == n_channels && image[idx] + image[idx + 1] + image[idx + 2] > 0 ) { return true; }
-  if ( 4 == n_channels && image[idx + 3] ) { return true; }
-  return false;
+/* Where and how glyphs are drawn: an image with any row stride, the rectangle of it that may be written to, and spans of the text and outline colours to copy
+or blend from. */
+typedef struct _dst_t {
+  unsigned char* image;                                 // first byte of the top row
+  ptrdiff_t stride;                                     // bytes from one row to the next. negative for bottom-up images
+  int n_channels;
+  int clip_x0, clip_y0, clip_x1, clip_y1;               // only pixels in x0..x1, y0..y1 (exclusive) are written
+  uint8_t alpha;                                        // text is blended over the image with this alpha. 0xFF copies the text colour instead
+  unsigned char span[_APG_PIXFONT_SPAN_PX * 4];         // _APG_PIXFONT_SPAN_PX pixels of the text colour
+  unsigned char outline_span[_APG_PIXFONT_SPAN_PX * 4]; // _APG_PIXFONT_SPAN_PX pixels of the outline colour
+} _dst_t;
+
+/* Fills span with _APG_PIXFONT_SPAN_PX pixels of the text colour. */
+static void _fill_span( unsigned char* span, int n_channels, unsigned char r, unsigned char g, unsigned char b, unsigned char a ) {
+  uint8_t colour[4] = {r, g, b, a};
+  if ( 2 == n_channels ) { colour[1] = a; } // 2-channel is usually RedAlpha, not RG.
+  for ( int i = 0; i < _APG_PIXFONT_SPAN_PX; i++ ) { memcpy( &span[i * n_channels], colour, n_channels ); }
+}
+
+/* Sets up a destination covering the whole of a tightly-packed image, with text overwriting pixels. */
+static void _init_dst( _dst_t* dst, unsigned char* image, int w, int h, int n_channels, unsigned char r, unsigned char g, unsigned char b, unsigned char a ) {
+  dst->image      = image;
+  dst->stride     = (ptrdiff_t)w * n_channels;
+  dst->n_channels = n_channels;
+  dst->clip_x0 = dst->clip_y0 = 0;
+  dst->clip_x1                = w;
+  dst->clip_y1                = h;
+  dst->alpha                  = 0xFF;
+  _fill_span( dst->span, n_channels, r, g, b, a );
+  // NOTE(Anton) could also user-specify an outline colour rather than all zero
+  _fill_span( dst->outline_span, n_channels, 0x00, 0x00, 0x00, 0xFF ); // don't set alpha to 0
 }
 
-// NOTE(Anton) could also user-specify an outline colour rather than all zero
-static void _apply_outline( unsigned char* image, int idx, int n_channels ) {
-  for ( int c = 0; c < n_channels; c++ ) { image[idx * n_channels + c] = 0x00; }
-  if ( 2 == n_channels ) { image[idx * n_channels + 1] = 0xFF; } // don't set alpha to 0
-  if ( 4 == n_channels ) { image[idx * n_channels + 3] = 0xFF; } // don't set alpha to 0
+/* dst = ( src * alpha + dst * ( 255 - alpha ) ) / 255 for each of n bytes, rounded to nearest. */
+static void _blend_bytes( unsigned char* dst, const unsigned char* src, int n, uint8_t alpha ) {
+  int i = 0;
+#if defined( _APG_PIXFONT_SSE2 )
+  const __m128i zero = _mm_setzero_si128(), a = _mm_set1_epi16( alpha ), inv_a = _mm_set1_epi16( 255 - alpha ), half = _mm_set1_epi16( 128 );
+  for ( ; i + 16 <= n; i += 16 ) {
+    __m128i s  = _mm_loadu_si128( (const __m128i*)&src[i] );
+    __m128i d  = _mm_loadu_si128( (const __m128i*)&dst[i] );
+    __m128i lo = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( s, zero ), a ), _mm_mullo_epi16( _mm_unpacklo_epi8( d, zero ), inv_a ) );
+    __m128i hi = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( s, zero ), a ), _mm_mullo_epi16( _mm_unpackhi_epi8( d, zero ), inv_a ) );
+    lo         = _mm_add_epi16( lo, half );
+    hi         = _mm_add_epi16( hi, half );
+    lo         = _mm_srli_epi16( _mm_add_epi16( lo, _mm_srli_epi16( lo, 8 ) ), 8 );
+    hi         = _mm_srli_epi16( _mm_add_epi16( hi, _mm_srli_epi16( hi, 8 ) ), 8 );
+    _mm_storeu_si128( (__m128i*)&dst[i], _mm_packus_epi16( lo, hi ) );
+  }
+#elif defined( _APG_PIXFONT_NEON )
+  const uint8x8_t a = vdup_n_u8( alpha ), inv_a = vdup_n_u8( (uint8_t)( 255 - alpha ) );
+  for ( ; i + 16 <= n; i += 16 ) {
+    uint8x16_t s = vld1q_u8( &src[i] ), d = vld1q_u8( &dst[i] );
+    uint16x8_t lo = vaddq_u16( vmull_u8( vget_low_u8( s ), a ), vmull_u8( vget_low_u8( d ), inv_a ) );
+    uint16x8_t hi = vaddq_u16( vmull_u8( vget_high_u8( s ), a ), vmull_u8( vget_high_u8( d ), inv_a ) );
+    lo            = vaddq_u16( lo, vdupq_n_u16( 128 ) );
+    hi            = vaddq_u16( hi, vdupq_n_u16( 128 ) );
+    vst1q_u8( &dst[i], vcombine_u8( vshrn_n_u16( vsraq_n_u16( lo, lo, 8 ), 8 ), vshrn_n_u16( vsraq_n_u16( hi, hi, 8 ), 8 ) ) );
+  }
+#endif
+  for ( ; i < n; i++ ) {
+    unsigned int t = src[i] * alpha + dst[i] * ( 255u - alpha ) + 128u;
+    dst[i]         = (unsigned char)( ( t + ( t >> 8 ) ) >> 8 );
+  }
+}
+
+/* Writes pixels x0 to x1 (exclusive) of row y from span, clipped to the destination's clip rectangle. y must already be inside the clip rectangle. */
+static void _put_run( const _dst_t* dst, int y, int x0, int x1, const unsigned char* span, uint8_t alpha ) {
+  x0                 = x0 > dst->clip_x0 ? x0 : dst->clip_x0;
+  x1                 = x1 < dst->clip_x1 ? x1 : dst->clip_x1;
+  unsigned char* row = dst->image + dst->stride * y;
+  for ( int x = x0; x < x1; x += _APG_PIXFONT_SPAN_PX ) {
+    int n_bytes = ( x1 - x < _APG_PIXFONT_SPAN_PX ? x1 - x : _APG_PIXFONT_SPAN_PX ) * dst->n_channels;
+    if ( 0xFF == alpha ) {
+      memcpy( &row[x * dst->n_channels], span, (size_t)n_bytes );
+    } else {
+      _blend_bytes( &row[x * dst->n_channels], span, n_bytes, alpha );
+    }
+  }
+}
+
+/* Draws one glyph's coloured runs, scaled by thickness, with its top-left at x_cursor,y_cursor. Anything outside the clip rectangle is clipped. */
+static void _blit_glyph( int glyph, int spacing_px, int x_cursor, int y_cursor, const _dst_t* dst, int thickness ) {
+  const uint8_t visible_mask = (uint8_t)( ( 1 << spacing_px ) - 1 );
+  for ( int y = 0; y < _font_img_h; y++ ) {
+    const _mask_runs_t* runs = &_mask_runs[_glyph_rows[glyph][y] & visible_mask];
+    if ( 0 == runs->n ) { continue; }
+    for ( int y_th = 0; y_th < thickness; y_th++ ) {
+      int image_y = y_cursor + y * thickness + y_th;
+      if ( image_y < dst->clip_y0 ) { continue; }
+      if ( image_y >= dst->clip_y1 ) { return; }
+      for ( int r = 0; r < runs->n; r++ ) {
+        int x0 = x_cursor + runs->start[r] * thickness;
+        _put_run( dst, image_y, x0, x0 + runs->len[r] * thickness, dst->span, dst->alpha );
+      }
+    }
+  }
+}
+
+/* Index of the lowest set bit. bits must not be 0. */
+static int _ctz64( uint64_t bits ) {
+#if defined( __GNUC__ ) || defined( __clang__ )
+  return __builtin_ctzll( bits );
+#else
+  int n = 0;
+  while ( !( bits & 1 ) ) {
+    bits >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+/* Coverage of the 64 pixels from strip_x onwards of one glyph row, after scaling by thickness. Bit i is pixel strip_x + i. */
+static uint64_t _scaled_row_strip( uint8_t row_mask, int thickness, int strip_x ) {
+  uint64_t bits = 0;
+  for ( int x = 0; x < _APG_PIXFONT_GLYPH_W; x++ ) {
+    if ( !( row_mask & ( 1 << x ) ) ) { continue; }
+    int px0 = x * thickness - strip_x, px1 = px0 + thickness;
+    px0 = px0 > 0 ? px0 : 0;
+    px1 = px1 < 64 ? px1 : 64;
+    if ( px0 >= px1 ) { continue; }
+    bits |= ( px1 - px0 == 64 ? ~(uint64_t)0 : ( ( (uint64_t)1 << ( px1 - px0 ) ) - 1 ) ) << px0;
+  }
+  return bits;
+}
+
+/* Copies each run of set bits in a strip of pixel bits into row y of the destination in the outline colour, starting at pixel x. */
+static void _blit_strip_bits( uint64_t bits, const _dst_t* dst, int x, int y ) {
+  while ( bits ) {
+    int start        = _ctz64( bits );
+    uint64_t shifted = ~( bits >> start );
+    int len          = shifted ? _ctz64( shifted ) : 64 - start;
+    bits &= len + start >= 64 ? ( ( (uint64_t)1 << start ) - 1 ) : ~( ( ( (uint64_t)1 << len ) - 1 ) << start );
+    _put_run( dst, y, x + start, x + start + len, dst->outline_span, 0xFF );
+  }
+}
+
+/* Draws the 1px outline to the right and bottom of one glyph, with the glyph's top-left at x_cursor,y_cursor. Anything outside the clip rectangle is clipped.
+The outline is the glyph's scaled coverage dilated by one pixel right, down, and diagonally, minus the coverage itself. It's computed with shifts and ORs on
+64-pixel strips of bits, so no image pixels are read and the cost scales with the glyph's area. Draw outlines before glyphs so that a glyph overwrites any
+outline that its neighbour spills into it. */
+static void _outline_glyph( int glyph, int spacing_px, int x_cursor, int y_cursor, const _dst_t* dst, int thickness ) {
+  const uint8_t visible_mask = (uint8_t)( ( 1 << spacing_px ) - 1 );
+  const int outline_w        = spacing_px * thickness + 1;
+  for ( int strip_x = 0; strip_x < outline_w && x_cursor + strip_x < dst->clip_x1; strip_x += 64 ) {
+    if ( x_cursor + strip_x + 64 <= dst->clip_x0 ) { continue; }
+    uint64_t prev_dilated = 0; // coverage of the previous row, dilated right
+    for ( int y = 0; y <= _font_img_h; y++ ) {
+      uint8_t row_mask = y < _font_img_h ? _glyph_rows[glyph][y] & visible_mask : 0;
+      uint64_t cov     = _scaled_row_strip( row_mask, thickness, strip_x );
+      uint64_t dilated = cov | cov << 1;
+      // carry in the last pixel of the strip to the left
+      if ( strip_x > 0 && ( row_mask >> ( ( strip_x - 1 ) / thickness ) ) & 1 ) { dilated |= 1; }
+      if ( dilated | prev_dilated ) {
+        uint64_t first_row = ( dilated | prev_dilated ) & ~cov; // the top scaled row of this glyph row also picks up the row above
+        uint64_t rest_rows = dilated & ~cov;
+        int n_rows         = y < _font_img_h ? thickness : 1;
+        for ( int y_th = 0; y_th < n_rows; y_th++ ) {
+          int image_y = y_cursor + y * thickness + y_th;
+          if ( image_y < dst->clip_y0 ) { continue; }
+          if ( image_y >= dst->clip_y1 ) { break; }
+          _blit_strip_bits( 0 == y_th ? first_row : rest_rows, dst, x_cursor + strip_x, image_y );
+        }
+      }
+      prev_dilated = dilated;
+    }
+  }
+}
+
+/* Draws one glyph, and its outline first if add_outline is set, with its top-left at x_cursor,y_cursor. Glyphs entirely outside the clip rectangle are
+skipped. */
+static void _draw_glyph( int glyph, int x_cursor, int y_cursor, const _dst_t* dst, int thickness, int add_outline ) {
+  int spacing_px = _glyph_advance[glyph];
+  if ( x_cursor >= dst->clip_x1 || y_cursor >= dst->clip_y1 ) { return; }
+  if ( x_cursor + spacing_px * thickness + 1 <= dst->clip_x0 || y_cursor + _font_img_h * thickness + 1 <= dst->clip_y0 ) { return; }
+  if ( add_outline ) { _outline_glyph( glyph, spacing_px, x_cursor, y_cursor, dst, thickness ); }
+  _blit_glyph( glyph, spacing_px, x_cursor, y_cursor, dst, thickness );
+}
+
+/* Draws a laid-out string with its top-left at x,y in the destination. */
+static void _draw_layout( const apg_pixfont_layout_t* layout, const _dst_t* dst, int x, int y ) {
+  for ( int i = 0; i < layout->n_glyphs; i++ ) {
+    const _glyph_pos_t* pos = &layout->glyphs[i];
+    _draw_glyph( pos->glyph, x + pos->x, y + pos->y, dst, layout->thickness, layout->add_outline );
+  }
+}
+
+/* Sets up a destination from a user's target description. RETURNS false if the target is invalid. */
+static bool _init_dst_from_target( _dst_t* dst, const apg_pixfont_target_t* target, unsigned char r, unsigned char g, unsigned char b, unsigned char a ) {
+  if ( !target->image || target->w < 0 || target->h < 0 || target->n_channels < 1 || target->n_channels > 4 ) { return false; }
+  ptrdiff_t row_bytes = (ptrdiff_t)target->w * target->n_channels;
+  ptrdiff_t stride    = 0 == target->stride ? row_bytes : target->stride;
+  if ( ( stride < 0 ? -stride : stride ) < row_bytes ) { return false; }
+
+  bool blend = APG_PIXFONT_BLEND_ALPHA == target->blend;
+  // when blending, the colour's alpha is the blend factor, and alpha channels are blended towards fully opaque.
+  _init_dst( dst, target->image, target->w, target->h, target->n_channels, r, g, b, blend ? 0xFF : a );
+  dst->stride = stride;
+  dst->alpha  = blend ? a : 0xFF;
+  if ( target->clip.w > 0 && target->clip.h > 0 ) {
+    dst->clip_x0 = target->clip.x > 0 ? target->clip.x : 0;
+    dst->clip_y0 = target->clip.y > 0 ? target->clip.y : 0;
+    dst->clip_x1 = target->clip.x + target->clip.w < target->w ? target->clip.x + target->clip.w : target->w;
+    dst->clip_y1 = target->clip.y + target->clip.h < target->h ? target->clip.y + target->clip.h : target->h;
+  }
+  return true;
+}
+
+/* Draws a whole string with its top-left at x,y in the destination, decoding it as it goes. */
+static void _draw_str( const char* str, int len, const _dst_t* dst, int x, int y, int thickness, int add_outline ) {
+  int x_cursor = x, y_cursor = y;
+  for ( int i = 0; i < len; ) {
+    int glyph = _next_glyph( str, len, &i );
+    if ( _APG_PIXFONT_GLYPH_NEWLINE == glyph ) {
+      y_cursor += _font_img_h * thickness;
+      x_cursor = x;
+      if ( y_cursor >= dst->clip_y1 ) { return; } // the rest is below the clip rectangle
+      continue;
+    }
+    if ( _APG_PIXFONT_GLYPH_SPACE == glyph ) {
+      x_cursor += 5 * thickness; // leave a gap
+      continue;
+    }
+    _draw_glyph( glyph, x_cursor, y_cursor, dst, thickness, add_outline );
+    x_cursor += _glyph_advance[glyph] * thickness;
+  } // endfor chars in str
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -152,74 +556,381 @@ int apg_pixfont_str_into_image( const char* ascii_str, unsigned char* image, int
   unsigned char a, int thickness, int add_outline ) {
   if ( !ascii_str || !image || n_channels < 1 || n_channels > 4 || thickness < 1 ) { return APG_PIXFONT_FAILURE; }
 
-  int len      = _apg_pixfont_strnlen( ascii_str, APG_PIXFONT_MAX_STRLEN );
-  int x_cursor = 0;
-  int y_cursor = 0;
+  _init_tables();
 
-  uint8_t colour[4] = {r, g, b, a};
-  if ( 2 == n_channels ) { colour[1] = a; } // 2-channel is usually RedAlpha, not RG.
+  _dst_t dst;
+  _init_dst( &dst, image, w, h, n_channels, r, g, b, a );
+  _draw_str( ascii_str, _apg_pixfont_strnlen( ascii_str, APG_PIXFONT_MAX_STRLEN ), &dst, 0, 0, thickness, add_outline );
 
-  for ( int i = 0; i < len; i++ ) {
-    if ( '\n' == ascii_str[i] ) {
-      y_cursor += _font_img_h * thickness;
+  return APG_PIXFONT_SUCCESS;
+}
+
+int apg_pixfont_str_into_target( const char* str, const apg_pixfont_target_t* target, unsigned char r, unsigned char g, unsigned char b, unsigned char a,
+  int thickness, int add_outline ) {
+  if ( !str || !target || thickness < 1 ) { return APG_PIXFONT_FAILURE; }
+
+  _init_tables();
+
+  _dst_t dst;
+  if ( !_init_dst_from_target( &dst, target, r, g, b, a ) ) { return APG_PIXFONT_FAILURE; }
+  _draw_str( str, _apg_pixfont_strnlen( str, APG_PIXFONT_MAX_STRLEN ), &dst, target->x, target->y, thickness, add_outline );
+
+  return APG_PIXFONT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* One band of image rows, and the lines of text that start in it, drawn by one thread. */
+typedef struct _band_job_t {
+  const char* str;
+  int start, end;             // byte range of the band's lines in str
+  int halo_start;             // start of the line above the band, whose outline spills into the band's top row. -1 if none
+  int y;                      // y_cursor of the band's first line
+  int thickness, add_outline;
+  _dst_t dst;                 // clipped to the band's rows
+} _band_job_t;
+
+static void _draw_band( const _band_job_t* job ) {
+  const int line_h = _font_img_h * job->thickness;
+  // glyphs of the line above are clipped away, leaving only its outline's bottom row. the band's own glyphs then draw over it, as in the serial order.
+  if ( job->add_outline && job->halo_start >= 0 ) {
+    _draw_str( job->str + job->halo_start, job->start - job->halo_start - 1, &job->dst, 0, job->y - line_h, job->thickness, job->add_outline );
+  }
+  _draw_str( job->str + job->start, job->end - job->start, &job->dst, 0, job->y, job->thickness, job->add_outline );
+}
+
+#ifndef APG_PIXFONT_NO_THREADS
+#ifdef _WIN32
+static DWORD WINAPI _band_thread( LPVOID job ) {
+  _draw_band( (const _band_job_t*)job );
+  return 0;
+}
+#else
+static void* _band_thread( void* job ) {
+  _draw_band( (const _band_job_t*)job );
+  return NULL;
+}
+#endif
+#endif
+
+int apg_pixfont_str_into_image_mt( const char* str, unsigned char* image, int w, int h, int n_channels, unsigned char r, unsigned char g, unsigned char b,
+  unsigned char a, int thickness, int add_outline, int n_threads ) {
+  if ( !str || !image || n_channels < 1 || n_channels > 4 || thickness < 1 ) { return APG_PIXFONT_FAILURE; }
+
+  // build the tables here rather than in each band's thread
+  _init_tables();
+
+  const int line_h = _font_img_h * thickness;
+  const int max_lines = ( h + line_h - 1 ) / line_h; // lines starting below the image aren't drawn
+  if ( max_lines < 1 ) { return APG_PIXFONT_SUCCESS; }
+
+  // pre-scan for line starts, up to the last visible line. '\n' is never part of a multi-byte UTF-8 sequence so this is safe before decoding.
+  int len = 0, n_lines = 1;
+  for ( ; str[len]; len++ ) {
+    if ( '\n' != str[len] ) { continue; }
+    if ( n_lines == max_lines ) { break; }
+    n_lines++;
+  }
+  int* line_starts = malloc( sizeof( int ) * n_lines );
+  if ( !line_starts ) { return APG_PIXFONT_FAILURE; }
+  line_starts[0] = 0;
+  for ( int i = 0, line = 1; line < n_lines; i++ ) {
+    if ( '\n' == str[i] ) { line_starts[line++] = i + 1; }
+  }
+
+  n_threads         = n_threads < 1 ? 1 : ( n_threads > APG_PIXFONT_MAX_THREADS ? APG_PIXFONT_MAX_THREADS : n_threads );
+  const int n_bands = n_threads < n_lines ? n_threads : n_lines;
+  _band_job_t* jobs = malloc( sizeof( _band_job_t ) * n_bands );
+  if ( !jobs ) {
+    free( line_starts );
+    return APG_PIXFONT_FAILURE;
+  }
+
+  // split into bands of whole lines with roughly equal numbers of bytes. each band's rows run from its first line's top down to the next band's first line.
+  _dst_t dst;
+  _init_dst( &dst, image, w, h, n_channels, r, g, b, a );
+  for ( int band = 0, line = 0; band < n_bands; band++ ) {
+    const int first_line = line;
+    const int share_end  = (int)( (int64_t)len * ( band + 1 ) / n_bands );
+    line++;
+    while ( line < n_lines - ( n_bands - band - 1 ) && line_starts[line] <= share_end ) { line++; }
+
+    _band_job_t* job  = &jobs[band];
+    job->str          = str;
+    job->start        = line_starts[first_line];
+    job->end          = line < n_lines ? line_starts[line] : len;
+    job->halo_start   = first_line > 0 ? line_starts[first_line - 1] : -1;
+    job->y            = first_line * line_h;
+    job->thickness    = thickness;
+    job->add_outline  = add_outline;
+    job->dst          = dst;
+    job->dst.clip_y0  = job->y;
+    job->dst.clip_y1  = band < n_bands - 1 && line * line_h < h ? line * line_h : h;
+  }
+
+  // this thread draws the first band while the others draw the rest
+#ifndef APG_PIXFONT_NO_THREADS
+#ifdef _WIN32
+  HANDLE threads[APG_PIXFONT_MAX_THREADS];
+#else
+  pthread_t threads[APG_PIXFONT_MAX_THREADS];
+#endif
+  bool started[APG_PIXFONT_MAX_THREADS] = { false };
+  for ( int band = 1; band < n_bands; band++ ) {
+#ifdef _WIN32
+    threads[band] = CreateThread( NULL, 0, _band_thread, &jobs[band], 0, NULL );
+    started[band] = NULL != threads[band];
+#else
+    started[band] = 0 == pthread_create( &threads[band], NULL, _band_thread, &jobs[band] );
+#endif
+    if ( !started[band] ) { _draw_band( &jobs[band] ); } // couldn't start a thread, so draw it here instead
+  }
+  _draw_band( &jobs[0] );
+  for ( int band = 1; band < n_bands; band++ ) {
+    if ( !started[band] ) { continue; }
+#ifdef _WIN32
+    WaitForSingleObject( threads[band], INFINITE );
+    CloseHandle( threads[band] );
+#else
+    pthread_join( threads[band], NULL );
+#endif
+  }
+#else
+  for ( int band = 0; band < n_bands; band++ ) { _draw_band( &jobs[band] ); }
+#endif
+
+  free( jobs );
+  free( line_starts );
+  return APG_PIXFONT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+apg_pixfont_layout_t* apg_pixfont_layout_create( const char* str, int thickness, int add_outline ) {
+  if ( !str || thickness < 1 ) { return NULL; }
+
+  _init_tables();
+
+  int len = _apg_pixfont_strnlen( str, APG_PIXFONT_MAX_STRLEN );
+  if ( 0 == len ) { return NULL; }
+
+  // every glyph takes at least one byte, so len entries is always enough
+  apg_pixfont_layout_t* layout = malloc( sizeof( apg_pixfont_layout_t ) + sizeof( _glyph_pos_t ) * len );
+  if ( !layout ) { return NULL; }
+  layout->thickness   = thickness;
+  layout->add_outline = add_outline;
+  layout->n_glyphs    = _layout_str( str, len, thickness, add_outline, layout->glyphs, &layout->w, &layout->h );
+  return layout;
+}
+
+void apg_pixfont_layout_free( apg_pixfont_layout_t* layout ) { free( layout ); }
+
+int apg_pixfont_layout_size( const apg_pixfont_layout_t* layout, int* w, int* h ) {
+  if ( !layout || !w || !h ) { return APG_PIXFONT_FAILURE; }
+  *w = layout->w;
+  *h = layout->h;
+  return APG_PIXFONT_SUCCESS;
+}
+
+int apg_pixfont_layout_into_image( const apg_pixfont_layout_t* layout, unsigned char* image, int w, int h, int x, int y, int n_channels, unsigned char r,
+  unsigned char g, unsigned char b, unsigned char a ) {
+  if ( !layout || !image || n_channels < 1 || n_channels > 4 || x < 0 || y < 0 ) { return APG_PIXFONT_FAILURE; }
+
+  _dst_t dst;
+  _init_dst( &dst, image, w, h, n_channels, r, g, b, a );
+  _draw_layout( layout, &dst, x, y );
+  return APG_PIXFONT_SUCCESS;
+}
+
+int apg_pixfont_layout_into_target( const apg_pixfont_layout_t* layout, const apg_pixfont_target_t* target, unsigned char r, unsigned char g, unsigned char b,
+  unsigned char a ) {
+  if ( !layout || !target ) { return APG_PIXFONT_FAILURE; }
+
+  _dst_t dst;
+  if ( !_init_dst_from_target( &dst, target, r, g, b, a ) ) { return APG_PIXFONT_FAILURE; }
+  _draw_layout( layout, &dst, target->x, target->y );
+  return APG_PIXFONT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+unsigned char* apg_pixfont_strs_into_atlas( const char** strs, int n_strs, apg_pixfont_rect_t* rects, int max_w, int* w, int* h, int n_channels,
+  unsigned char r, unsigned char g, unsigned char b, unsigned char a, int thickness, int add_outline ) {
+  if ( !strs || n_strs < 1 || !rects || !w || !h || n_channels < 1 || n_channels > 4 || thickness < 1 ) { return NULL; }
+
+  _init_tables();
+
+  *w = *h = 0;
+
+  // one block holds every string's layout header and glyphs, so laying out the whole batch is a single allocation. each layout is packed after the previous
+  // one's glyphs, and a string never has more glyphs than bytes, so the block sized by string lengths is always big enough.
+  size_t total_bytes = 0;
+  for ( int i = 0; i < n_strs; i++ ) {
+    if ( !strs[i] ) { return NULL; }
+    total_bytes += sizeof( apg_pixfont_layout_t ) + sizeof( _glyph_pos_t ) * _apg_pixfont_strnlen( strs[i], APG_PIXFONT_MAX_STRLEN );
+  }
+  unsigned char* layouts_mem = malloc( total_bytes );
+  if ( !layouts_mem ) { return NULL; }
+
+  // lay out each string and pack its rectangle into shelves: rows of rects filled left-to-right, starting a new shelf when the next rect won't fit in max_w.
+  int shelf_x = 0, shelf_y = 0, shelf_h = 0;
+  size_t offset = 0;
+  for ( int i = 0; i < n_strs; i++ ) {
+    apg_pixfont_layout_t* layout = (apg_pixfont_layout_t*)&layouts_mem[offset];
+    int len                      = _apg_pixfont_strnlen( strs[i], APG_PIXFONT_MAX_STRLEN );
+    layout->thickness            = thickness;
+    layout->add_outline          = add_outline;
+    layout->n_glyphs             = _layout_str( strs[i], len, thickness, add_outline, layout->glyphs, &layout->w, &layout->h );
+    if ( 0 == len ) { layout->w = layout->h = 0; } // empty strings get an empty rect
+    offset += sizeof( apg_pixfont_layout_t ) + sizeof( _glyph_pos_t ) * layout->n_glyphs;
+
+    if ( shelf_x > 0 && shelf_x + layout->w > max_w ) {
+      shelf_y += shelf_h;
+      shelf_x = shelf_h = 0;
+    }
+    rects[i] = ( apg_pixfont_rect_t ){ .x = shelf_x, .y = shelf_y, .w = layout->w, .h = layout->h };
+    shelf_x += layout->w;
+    shelf_h = layout->h > shelf_h ? layout->h : shelf_h;
+    *w      = shelf_x > *w ? shelf_x : *w;
+  }
+  *h = shelf_y + shelf_h;
+  if ( 0 == *w || 0 == *h ) {
+    free( layouts_mem );
+    return NULL;
+  }
+
+  unsigned char* image = calloc( 1, (size_t)*w * *h * n_channels );
+  if ( !image ) {
+    free( layouts_mem );
+    return NULL;
+  }
+  _dst_t dst;
+  _init_dst( &dst, image, *w, *h, n_channels, r, g, b, a );
+  offset = 0;
+  for ( int i = 0; i < n_strs; i++ ) {
+    const apg_pixfont_layout_t* layout = (const apg_pixfont_layout_t*)&layouts_mem[offset];
+    _draw_layout( layout, &dst, rects[i].x, rects[i].y );
+    offset += sizeof( apg_pixfont_layout_t ) + sizeof( _glyph_pos_t ) * layout->n_glyphs;
+  }
+
+  free( layouts_mem );
+  return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int apg_pixfont_glyph_for_codepoint( uint32_t codepoint ) {
+  _init_tables();
+
+  if ( ' ' == codepoint || '\n' == codepoint ) { return -1; }
+  if ( codepoint > _APG_PIXFONT_MAX_CODEPOINT ) { return _glyph_unknown; }
+  uint8_t glyph = _cp_pages[_cp_page_of[codepoint >> 8]][codepoint & 0xFF];
+  return _APG_PIXFONT_NO_GLYPH == glyph ? _glyph_unknown : glyph;
+}
+
+#define _APG_PIXFONT_SDF_COLS 16 // glyph cells per row of the SDF atlas
+
+/* Signed distance in font pixels from point px,py to the edge of a glyph's visible pixels, where each coloured pixel is a unit square. Positive inside.
+Distances are only searched out to max_dist, and clamped to that. */
+static float _glyph_distance( int glyph, uint8_t visible_mask, float px, float py, int max_dist ) {
+  int cx = (int)floorf( px ), cy = (int)floorf( py );
+  bool inside = cx >= 0 && cx < _APG_PIXFONT_GLYPH_W && cy >= 0 && cy < _font_img_h && ( ( _glyph_rows[glyph][cy] & visible_mask ) >> cx ) & 1;
+  float best  = (float)max_dist;
+  for ( int y = cy - max_dist; y <= cy + max_dist; y++ ) {
+    for ( int x = cx - max_dist; x <= cx + max_dist; x++ ) {
+      bool coloured = x >= 0 && x < _APG_PIXFONT_GLYPH_W && y >= 0 && y < _font_img_h && ( ( _glyph_rows[glyph][y] & visible_mask ) >> x ) & 1;
+      if ( coloured == inside ) { continue; } // looking for the nearest pixel of the other kind
+      float dx = px < x ? x - px : ( px > x + 1 ? px - ( x + 1 ) : 0.0f );
+      float dy = py < y ? y - py : ( py > y + 1 ? py - ( y + 1 ) : 0.0f );
+      float d  = sqrtf( dx * dx + dy * dy );
+      best     = d < best ? d : best;
+    }
+  }
+  return inside ? best : -best;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+unsigned char* apg_pixfont_sdf_atlas( int scale, int padding, int* w, int* h, apg_pixfont_glyph_metrics_t* metrics ) {
+  if ( scale < 1 || padding < 1 || !w || !h ) { return NULL; }
+
+  _init_tables();
+
+  const int cell_w = ( _APG_PIXFONT_GLYPH_W + 2 * padding ) * scale, cell_h = ( _font_img_h + 2 * padding ) * scale;
+  const int n_rows = ( APG_PIXFONT_N_GLYPHS + _APG_PIXFONT_SDF_COLS - 1 ) / _APG_PIXFONT_SDF_COLS;
+  *w               = cell_w * _APG_PIXFONT_SDF_COLS;
+  *h               = cell_h * n_rows;
+
+  unsigned char* image = calloc( 1, (size_t)*w * *h );
+  if ( !image ) { return NULL; }
+
+  for ( int glyph = 0; glyph < APG_PIXFONT_N_GLYPHS; glyph++ ) {
+    const uint8_t visible_mask = (uint8_t)( ( 1 << _glyph_advance[glyph] ) - 1 );
+    const int cell_x = ( glyph % _APG_PIXFONT_SDF_COLS ) * cell_w, cell_y = ( glyph / _APG_PIXFONT_SDF_COLS ) * cell_h;
+    for ( int y = 0; y < cell_h; y++ ) {
+      for ( int x = 0; x < cell_w; x++ ) {
+        // sample at the texel centre, in font pixels relative to the glyph's top-left
+        float px   = ( x + 0.5f ) / scale - padding, py = ( y + 0.5f ) / scale - padding;
+        float dist = _glyph_distance( glyph, visible_mask, px, py, padding );
+        int value  = (int)( 127.5f + dist / padding * 127.5f + 0.5f );
+        image[( cell_y + y ) * *w + cell_x + x] = (unsigned char)( value < 0 ? 0 : ( value > 255 ? 255 : value ) );
+      }
+    }
+    if ( metrics ) {
+      apg_pixfont_glyph_metrics_t* m = &metrics[glyph];
+      m->codepoint                   = _glyph_codepoint[glyph];
+      m->u0                          = (float)cell_x / *w;
+      m->v0                          = (float)cell_y / *h;
+      m->u1                          = (float)( cell_x + cell_w ) / *w;
+      m->v1                          = (float)( cell_y + cell_h ) / *h;
+      m->x_offset                    = (float)-padding;
+      m->y_offset                    = (float)-padding;
+      m->quad_w                      = (float)( _APG_PIXFONT_GLYPH_W + 2 * padding );
+      m->quad_h                      = (float)( _font_img_h + 2 * padding );
+      m->advance                     = _glyph_advance[glyph];
+    }
+  }
+  return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int apg_pixfont_atlas_into_image( unsigned char* image ) {
+  if ( !image ) { return APG_PIXFONT_FAILURE; }
+  assert( APG_PIXFONT_ATLAS_W == _font_img_w && APG_PIXFONT_ATLAS_H == _font_img_h );
+  for ( int i = 0; i < _font_img_w * _font_img_h; i++ ) { image[i] = _font_img[i] > 0x00 ? 0xFF : 0x00; }
+  return APG_PIXFONT_SUCCESS;
+}
+
+int apg_pixfont_str_to_quads( const char* str, float x, float y, int thickness, apg_pixfont_quad_t* quads, int max_quads ) {
+  if ( !str || thickness < 1 || max_quads < 0 || ( !quads && max_quads > 0 ) ) { return 0; }
+
+  _init_tables();
+
+  int len = _apg_pixfont_strnlen( str, APG_PIXFONT_MAX_STRLEN );
+  int x_cursor = 0, y_cursor = 0, n_quads = 0;
+
+  for ( int i = 0; i < len; ) {
+    int glyph = _next_glyph( str, len, &i );
+    if ( _APG_PIXFONT_GLYPH_NEWLINE == glyph ) {
+      y_cursor += _font_img_h;
       x_cursor = 0;
       continue;
     }
-    if ( ' ' == ascii_str[i] || '\n' == ascii_str[i] ) {
-      x_cursor += 5 * thickness; // leave a gap
+    if ( _APG_PIXFONT_GLYPH_SPACE == glyph ) {
+      x_cursor += 5; // leave a gap
       continue;
     }
-    int additional_i     = 0;
-    uint32_t atlas_index = _atlas_index_for_sequence( &ascii_str[i], &additional_i );
-    i += additional_i;
-    int spacing_px = _get_spacing_for_codepoint( atlas_index );
-    atlas_index -= 33;
-    for ( int y = 0; y < _font_img_h; y++ ) {
-      for ( int x = 0; x < spacing_px; x++ ) {
-        int atlas_x       = atlas_index * 6 + x;
-        int atlas_y       = y;
-        int atlas_img_idx = _font_img_w * atlas_y + atlas_x;
-        if ( _font_img[atlas_img_idx] > 0x00 ) {
-          for ( int y_th = 0; y_th < thickness; y_th++ ) {
-            for ( int x_th = 0; x_th < thickness; x_th++ ) {
-              int image_x     = x_cursor + x * thickness + x_th;
-              int image_y     = y_cursor + y * thickness + y_th;
-              int out_img_idx = w * image_y + image_x;
-              if ( out_img_idx >= w * h ) { continue; }
-              for ( int c = 0; c < n_channels; c++ ) { image[out_img_idx * n_channels + c] = colour[c]; }
-            }
-          }
-        } // endif colours
-      }   // endfor glyph x
-    }     // endfor glyph y
-    x_cursor += spacing_px * thickness;
+    int advance = _glyph_advance[glyph];
+    if ( n_quads < max_quads ) {
+      // the quad only covers the glyph's advance, so columns of the atlas cell beyond that aren't drawn - same as str_into_image().
+      apg_pixfont_quad_t* q = &quads[n_quads];
+      q->x0                 = x + (float)( x_cursor * thickness );
+      q->y0                 = y + (float)( y_cursor * thickness );
+      q->x1                 = q->x0 + (float)( advance * thickness );
+      q->y1                 = q->y0 + (float)( _font_img_h * thickness );
+      q->u0                 = (float)( glyph * _APG_PIXFONT_GLYPH_W ) / _font_img_w;
+      q->v0                 = 0.0f;
+      q->u1                 = (float)( glyph * _APG_PIXFONT_GLYPH_W + advance ) / _font_img_w;
+      q->v1                 = 1.0f;
+    }
+    n_quads++;
+    x_cursor += advance;
   } // endfor chars in str
 
-  // NOTE(Anton) this is verbose because i have to do a whole 'nother loop order and y neighbour direction if the image memory is vertically flipped.
-  if ( add_outline ) {
-    for ( int y = h - 1; y >= 0; y-- ) {
-      for ( int x = w - 1; x >= 0; x-- ) {
-        if ( _is_img_idx_coloured( image, n_channels * ( w * y + x ), n_channels ) ) { continue; }
-        if ( y > 0 ) {
-          if ( _is_img_idx_coloured( image, n_channels * ( w * ( y - 1 ) + x ), n_channels ) ) {
-            _apply_outline( image, w * y + x, n_channels );
-            continue;
-          }
-        }
-        if ( x > 0 ) {
-          if ( _is_img_idx_coloured( image, n_channels * ( w * y + ( x - 1 ) ), n_channels ) ) {
-            _apply_outline( image, w * y + x, n_channels );
-            continue;
-          }
-        }
-        if ( y > 0 && x > 0 ) {
-          if ( _is_img_idx_coloured( image, n_channels * ( w * ( y - 1 ) + ( x - 1 ) ), n_channels ) ) {
-            _apply_outline( image, w * y + x, n_channels );
-            continue;
-          }
-        }
-      } // endforx
-    }   // endfor y
-  }     // endfor outline
-  return APG_PIXFONT_SUCCESS;
+  return n_quads;
 }
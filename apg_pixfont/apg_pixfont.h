@@ -1,4 +1,4 @@
-/* apg_pixfont - C Pixel Font Utility v0.0.5
+/* apg_pixfont - C Pixel Font Utility v0.1.3
 LICENCE: see bottom of this file
 ==============================================================
 Authors and Contributors:
@@ -46,6 +46,8 @@ apg_pixfont_str_into_image( "my_string", img_mem, w, h, n_channels, 0xFF, 0x7F,
 Technical Details:
 ==============================================================
 - Implementation is C99, interface is C89.
+- The glyph tables are built on the first call to any function. This is guarded with pthread_once/InitOnceExecuteOnce, so functions may be called from several
+  threads at once. Link with -pthread on Linux. With APG_PIXFONT_NO_THREADS defined, make one call before starting any threads that use the library.
 
 TODO:
 ==============================================================
@@ -53,6 +55,14 @@ TODO:
 
 History:
 ==============================================================
+0.1.3 - 2026 Oct 18 - Multi-threaded rendering of large text blocks in bands of lines.
+0.1.2 - 2026 Oct 18 - Draw targets with row stride, clip rectangle, origin, and alpha blending (SSE2/NEON).
+0.1.1 - 2026 Oct 18 - Textured quad output per glyph and atlas image export, for drawing text on the GPU without rasterising it.
+0.1.0 - 2026 Oct 18 - Signed distance field atlas and per-glyph metrics for drawing text with quads on the GPU.
+0.0.9 - 2026 Oct 18 - Outlines built from glyph bitmasks around each glyph, instead of scanning the whole image. Existing image content is no longer outlined.
+0.0.8 - 2026 Oct 18 - Layout objects that decode a string once, and batch rendering of many strings into one atlas image.
+0.0.7 - 2026 Oct 18 - UTF-8 decoded in a single pass and looked up in a codepoint->glyph page table. Unsupported multi-byte characters draw one '?'.
+0.0.6 - 2026 Oct 18 - Glyphs pre-rasterised into row bitmasks and drawn as runs. Text now clips at the image's right edge instead of wrapping.
 0.0.5 - 2022 Apr 17 - Reduced text space required for hard-coded image array.
 0.0.4 - 2022 Jan 05 - Removed vflip again, to simplify code in several places.
 0.0.3 - 2019 Aug 11 - Added vflip option back in, and reconciled with outline drawing block.
@@ -63,6 +73,8 @@ History:
 #ifndef _APG_PIXFONT_H_
 #define _APG_PIXFONT_H_
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -70,6 +82,7 @@ extern "C" {
 #define APG_PIXFONT_FAILURE 0
 #define APG_PIXFONT_SUCCESS 1
 #define APG_PIXFONT_MAX_STRLEN 2048
+#define APG_PIXFONT_MAX_THREADS 64
 
 /* Get image dimensions required for writing full string into with str_into_image()
 
@@ -109,6 +122,180 @@ RETURNS:
 int apg_pixfont_str_into_image( const char* ascii_str, unsigned char* image, int w, int h, int n_channels, unsigned char r, unsigned char g, unsigned char b,
   unsigned char a, int thickness, int add_outline );
 
+/* A string decoded and laid out once, so it can be measured and drawn without walking the string again. Opaque. */
+typedef struct apg_pixfont_layout_t apg_pixfont_layout_t;
+
+/* Position and size of one string's image within an atlas image. */
+typedef struct apg_pixfont_rect_t {
+  int x, y, w, h;
+} apg_pixfont_rect_t;
+
+/* Decodes and lays out a string in a single pass.
+
+ARGUMENTS:
+* str - null-terminated string to lay out, as for apg_pixfont_str_into_image().
+* thickness, add_outline - as for apg_pixfont_str_into_image(). These are fixed for the life of the layout.
+
+RETURNS:
+* A new layout, or NULL on error (zero-length strings, NULL pointer args, out of memory). Free it with apg_pixfont_layout_free().
+*/
+apg_pixfont_layout_t* apg_pixfont_layout_create( const char* str, int thickness, int add_outline );
+
+void apg_pixfont_layout_free( apg_pixfont_layout_t* layout );
+
+/* Get image dimensions required for drawing the whole layout. Same as apg_pixfont_image_size_for_str() for the same string.
+RETURNS:
+* APG_PIXFONT_FAILURE on error (NULL pointer args), otherwise success
+*/
+int apg_pixfont_layout_size( const apg_pixfont_layout_t* layout, int* w, int* h );
+
+/* Draws a layout into an image with its top-left corner at x,y. Anything outside the image is clipped.
+
+ARGUMENTS:
+* image, w, h, n_channels, r,g,b,a - as for apg_pixfont_str_into_image().
+* x, y - position in the image to draw at. Must not be negative.
+
+RETURNS:
+* APG_PIXFONT_FAILURE on error, otherwise success
+*/
+int apg_pixfont_layout_into_image( const apg_pixfont_layout_t* layout, unsigned char* image, int w, int h, int x, int y, int n_channels, unsigned char r,
+  unsigned char g, unsigned char b, unsigned char a );
+
+/* Renders a batch of strings into a single newly allocated atlas image, eg for uploading many labels as one texture.
+Each string is decoded once. Strings are packed into rows ("shelves") in the order given.
+
+ARGUMENTS:
+* strs - array of n_strs null-terminated strings. Empty strings are given an empty rect.
+* rects - array of n_strs rects to write each string's position and size in the atlas into.
+* max_w - preferred maximum width of the atlas image in pixels. A string wider than this gets a row to itself, and the atlas widens to fit it.
+* w, h - set to the dimensions of the atlas image.
+* n_channels, r,g,b,a, thickness, add_outline - as for apg_pixfont_str_into_image(). Background pixels are 0.
+
+RETURNS:
+* The atlas image, w * h * n_channels bytes, which the caller must free() - or NULL on error.
+*/
+unsigned char* apg_pixfont_strs_into_atlas( const char** strs, int n_strs, apg_pixfont_rect_t* rects, int max_w, int* w, int* h, int n_channels,
+  unsigned char r, unsigned char g, unsigned char b, unsigned char a, int thickness, int add_outline );
+
+/* Number of glyphs in the font. Glyph indices run from 0 to APG_PIXFONT_N_GLYPHS - 1. */
+#define APG_PIXFONT_N_GLYPHS 123
+
+/* Where to find and how to place one glyph when drawing text with textured quads from the SDF atlas.
+All positions and sizes are in font pixels, which are 1px at thickness 1. Multiply them by your text scale.
+Spaces advance the pen 5 font pixels, and each line of text is 16 font pixels below the last. */
+typedef struct apg_pixfont_glyph_metrics_t {
+  uint32_t codepoint;       // Unicode codepoint this glyph draws.
+  float u0, v0, u1, v1;     // Texture coordinates of the glyph's cell in the atlas, top-left to bottom-right, including padding.
+  float x_offset, y_offset; // Top-left of the quad relative to the pen position (the top-left of the glyph's 6x16 box). y points down.
+  float quad_w, quad_h;     // Size of the quad.
+  int advance;              // Distance to move the pen right after drawing this glyph.
+} apg_pixfont_glyph_metrics_t;
+
+/* Get the glyph index used to draw a Unicode codepoint, eg to look up its metrics.
+RETURNS:
+* The glyph index, the index of '?' for codepoints the font doesn't have, or -1 for space and line break, which aren't drawn.
+*/
+int apg_pixfont_glyph_for_codepoint( uint32_t codepoint );
+
+/* Generates a single-channel signed distance field (SDF) atlas of every glyph in the font, for drawing text at any scale on the GPU.
+Do this once at start-up, upload the image as a texture with linear filtering, and draw each glyph as a quad using its metrics.
+In the shader, texel values above 0.5 are inside the glyph. Use smoothstep() around 0.5 for anti-aliased edges, or a lower threshold for an outline.
+
+ARGUMENTS:
+* scale - SDF texels per font pixel. 4-8 keeps the pixel font's square corners crisp at large sizes.
+* padding - Font pixels of padding around each glyph cell. This is also the distance range encoded: 0 and 255 are padding font pixels outside and inside the edge.
+* w, h - set to the dimensions of the atlas image.
+* metrics - if not NULL, an array of APG_PIXFONT_N_GLYPHS metrics, indexed by glyph index, which is filled in.
+
+RETURNS:
+* The atlas image, w * h bytes, which the caller must free() - or NULL on error.
+*/
+unsigned char* apg_pixfont_sdf_atlas( int scale, int padding, int* w, int* h, apg_pixfont_glyph_metrics_t* metrics );
+
+/* Dimensions of the font's atlas image. Glyph index g is in the 6-pixel-wide cell starting at x = g * 6. */
+#define APG_PIXFONT_ATLAS_W 800
+#define APG_PIXFONT_ATLAS_H 16
+
+/* One textured quad for drawing a glyph straight from the atlas image. */
+typedef struct apg_pixfont_quad_t {
+  float x0, y0, x1, y1; // Top-left and bottom-right of the quad, in pixels, with y pointing down.
+  float u0, v0, u1, v1; // Texture coordinates of the glyph in the atlas image, with v = 0 at the top row.
+} apg_pixfont_quad_t;
+
+/* Copies the font's atlas image into a 1-channel image, eg for uploading once as a texture to draw text from with apg_pixfont_str_to_quads().
+Glyph pixels are 0xFF and the background is 0x00. Use nearest-neighbour filtering to keep the pixels crisp.
+
+ARGUMENTS:
+* image - a pre-allocated block of APG_PIXFONT_ATLAS_W * APG_PIXFONT_ATLAS_H bytes.
+
+RETURNS:
+* APG_PIXFONT_FAILURE on error (NULL pointer args), otherwise success
+*/
+int apg_pixfont_atlas_into_image( unsigned char* image );
+
+/* Lays out a string as one textured quad per glyph, instead of drawing it into an image. Spaces and line breaks only move the pen.
+Draw the quads with the atlas image from apg_pixfont_atlas_into_image() as a texture, eg as one instanced draw call. Outlines are not generated.
+
+ARGUMENTS:
+* str - null-terminated string, as for apg_pixfont_str_into_image().
+* x, y - position of the top-left of the text, in pixels.
+* thickness - A scaling factor for the text, as for apg_pixfont_str_into_image().
+* quads - array of max_quads quads to write into. May be NULL if max_quads is 0, to count the quads required.
+
+RETURNS:
+* The number of quads the whole string needs, which may be more than max_quads - in that case only the first max_quads are written. 0 on error.
+*/
+int apg_pixfont_str_to_quads( const char* str, float x, float y, int thickness, apg_pixfont_quad_t* quads, int max_quads );
+
+/* How text pixels are combined with the pixels already in a target image. */
+typedef enum apg_pixfont_blend_t {
+  APG_PIXFONT_BLEND_NONE = 0, // Text pixels overwrite the image, the same as apg_pixfont_str_into_image().
+  APG_PIXFONT_BLEND_ALPHA     // Text is blended over the image, using the text colour's alpha as opacity. Alpha channels in the image become more opaque.
+} apg_pixfont_blend_t;
+
+/* An image, or part of one, to draw text straight into - eg a mapped framebuffer or a sub-rectangle of a larger texture. */
+typedef struct apg_pixfont_target_t {
+  unsigned char* image;     // Pointer to the first byte of the top row of the image.
+  int w, h;                 // Dimensions of the image in pixels.
+  int n_channels;           // 1 to 4, as for apg_pixfont_str_into_image().
+  int stride;               // Bytes from the start of one row to the next. 0 means w * n_channels. Negative for bottom-up images.
+  int x, y;                 // Where to put the top-left of the text in the image. May be negative.
+  apg_pixfont_rect_t clip;  // Only pixels inside this rectangle are written. A w or h of 0 means the whole image.
+  apg_pixfont_blend_t blend;
+} apg_pixfont_target_t;
+
+/* Draws a string into a target image, clipped to its clip rectangle, and optionally blended over the existing pixels.
+Outlines are always drawn opaque.
+
+ARGUMENTS:
+* str, r,g,b,a, thickness, add_outline - as for apg_pixfont_str_into_image().
+
+RETURNS:
+* APG_PIXFONT_FAILURE on error (NULL pointer args, invalid target), otherwise success
+*/
+int apg_pixfont_str_into_target( const char* str, const apg_pixfont_target_t* target, unsigned char r, unsigned char g, unsigned char b, unsigned char a,
+  int thickness, int add_outline );
+
+/* Draws a layout into a target image, as for apg_pixfont_str_into_target(). */
+int apg_pixfont_layout_into_target( const apg_pixfont_layout_t* layout, const apg_pixfont_target_t* target, unsigned char r, unsigned char g, unsigned char b,
+  unsigned char a );
+
+/* Multi-threaded version of apg_pixfont_str_into_image() for large blocks of text, eg log viewers.
+The image is split into horizontal bands of whole lines, and each band is drawn by its own thread, including its outline.
+The result is identical to apg_pixfont_str_into_image(). Unlike that function, the string length is not limited to APG_PIXFONT_MAX_STRLEN.
+Build with APG_PIXFONT_NO_THREADS defined to draw the bands one after another instead, eg on platforms without threads.
+On Linux link with -pthread.
+
+ARGUMENTS:
+* str, image, w, h, n_channels, r,g,b,a, thickness, add_outline - as for apg_pixfont_str_into_image().
+* n_threads - number of threads to use, including the calling thread, up to APG_PIXFONT_MAX_THREADS. Fewer are used if there are fewer visible lines.
+
+RETURNS:
+* APG_PIXFONT_FAILURE on error, otherwise success
+*/
+int apg_pixfont_str_into_image_mt( const char* str, unsigned char* image, int w, int h, int n_channels, unsigned char r, unsigned char g, unsigned char b,
+  unsigned char a, int thickness, int add_outline, int n_threads );
+
 #ifdef __cplusplus
 }
 #endif /* extern C */
@@ -5,4 +5,5 @@ FLAGS="-g -Wall -Wextra -pedantic -Werror"
 SAN="" # -fsanitize=address -fsanitize=undefined"
 $CPP $FLAGS $SAN -c tests/test_pixfont.cpp -o tests/test_pixfont.o -I ./
 $CC $FLAGS $SAN -c apg_pixfont.c -o apg_pixfont.o -I ./
-$CPP apg_pixfont.o tests/test_pixfont.o -lm
+$CPP apg_pixfont.o tests/test_pixfont.o -lm -pthread
+$CC -O2 $FLAGS -o bench_pixfont tests/bench_pixfont.c apg_pixfont.c -I ./ -I ../apg/ -lm -pthread # no sanitizers, for meaningful timings
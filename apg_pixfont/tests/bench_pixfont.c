@@ -0,0 +1,93 @@
+/* Rendering throughput benchmark for apg_pixfont.
+Reports glyphs drawn per second, and MB of output image per second (the whole image, including background pixels), for a range of string lengths, thicknesses, channel counts and outlines.
+For meaningful numbers build with optimisations and without sanitizers, eg:
+  cc -O2 -I./ -I../apg/ tests/bench_pixfont.c apg_pixfont.c -lm -pthread -o bench_pixfont
+Usage: ./bench_pixfont [MIN_SECONDS_PER_CASE]
+*/
+
+#define APG_IMPLEMENTATION
+#include "apg.h"
+#include "apg_pixfont.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static double _min_s = 0.1; // each case repeats until it has run for at least this long
+
+/* Renders str repeatedly into an image of w x h and prints the throughput. If w or h is 0 the image is sized to fit the string. n_threads 0 uses the serial
+renderer. n_glyphs 0 counts the glyphs in str, which only works up to APG_PIXFONT_MAX_STRLEN. */
+static void _bench( const char* label, const char* str, int n_glyphs, int w, int h, int n_channels, int thickness, int add_outline, int n_threads ) {
+  if ( 0 == w || 0 == h ) { apg_pixfont_image_size_for_str( str, &w, &h, thickness, add_outline ); }
+  unsigned char* img = (unsigned char*)calloc( 1, (size_t)w * h * n_channels );
+  if ( !img ) {
+    fprintf( stderr, "ERROR: allocating %ix%i image\n", w, h );
+    return;
+  }
+  if ( 0 == n_glyphs ) { n_glyphs = apg_pixfont_str_to_quads( str, 0.0f, 0.0f, thickness, NULL, 0 ); }
+
+  int n_reps       = 0;
+  double start_s   = apg_time_s();
+  double elapsed_s = 0.0;
+  do {
+    if ( n_threads > 0 ) {
+      apg_pixfont_str_into_image_mt( str, img, w, h, n_channels, 0xFF, 0xFF, 0xFF, 0xFF, thickness, add_outline, n_threads );
+    } else {
+      apg_pixfont_str_into_image( str, img, w, h, n_channels, 0xFF, 0xFF, 0xFF, 0xFF, thickness, add_outline );
+    }
+    n_reps++;
+    elapsed_s = apg_time_s() - start_s;
+  } while ( elapsed_s < _min_s );
+
+  double glyphs_per_s = (double)n_glyphs * n_reps / elapsed_s;
+  double mb_per_s     = (double)w * h * n_channels * n_reps / elapsed_s / ( 1024.0 * 1024.0 );
+  printf( "%-8s %5ix%-5i %2i %2i %7s %3i %10.3f %12.0f %10.1f\n", label, w, h, n_channels, thickness, add_outline ? "yes" : "no", n_threads,
+    elapsed_s * 1000.0 / n_reps, glyphs_per_s, mb_per_s );
+  free( img );
+}
+
+int main( int argc, char** argv ) {
+  if ( argc > 1 ) { _min_s = atof( argv[1] ); }
+
+  apg_time_init();
+
+  // strings of different lengths. the long one is a block of lines, up to the single-threaded length limit.
+  static char long_str[APG_PIXFONT_MAX_STRLEN];
+  {
+    int len = 0;
+    for ( int line = 0; len < APG_PIXFONT_MAX_STRLEN - 64; line++ ) {
+      len += snprintf( &long_str[len], sizeof( long_str ) - len, "[%04i] The quick brown fox jumps over the lazy dog.\n", line );
+    }
+  }
+  const char* labels[]    = { "short", "line", "block" };
+  const char* strs[]      = { "Hello, World!", "An bhfuil cead agam dul go dtí an leithreas? {ÄÖÜ} (1234567890) ~!@#$%^&*", long_str };
+  const int thicknesses[] = { 1, 2, 4, 8 };
+
+  printf( "%-8s %11s %2s %2s %7s %3s %10s %12s %10s\n", "string", "image", "ch", "th", "outline", "thr", "ms/render", "glyphs/s", "MB/s" );
+  for ( int s = 0; s < 3; s++ ) {
+    for ( int t = 0; t < 4; t++ ) {
+      for ( int n_channels = 1; n_channels <= 4; n_channels++ ) {
+        for ( int add_outline = 0; add_outline <= 1; add_outline++ ) { _bench( labels[s], strs[s], 0, 0, 0, n_channels, thicknesses[t], add_outline, 0 ); }
+      }
+    }
+  }
+
+  // worst case: a short string drawn into a big image, where per-image rather than per-glyph work would dominate
+  for ( int add_outline = 0; add_outline <= 1; add_outline++ ) { _bench( "short", strs[0], 0, 1920, 1080, 4, 1, add_outline, 0 ); }
+
+  // a log dump, beyond the single-threaded length limit, split across threads
+  {
+    const int n_lines = 1000, line_bytes = 52;
+    char* dump_str    = (char*)malloc( (size_t)n_lines * line_bytes + 1 );
+    if ( !dump_str ) { return 1; }
+    for ( int line = 0; line < n_lines; line++ ) {
+      snprintf( &dump_str[line * line_bytes], line_bytes + 1, "[%04i] The quick brown fox jumps over the lazy dog.\n", line );
+    }
+    char first_line[64];
+    snprintf( first_line, line_bytes, "%s", dump_str );
+    int n_glyphs = n_lines * apg_pixfont_str_to_quads( first_line, 0.0f, 0.0f, 1, NULL, 0 );
+    for ( int n_threads = 1; n_threads <= 8; n_threads *= 2 ) { _bench( "dump", dump_str, n_glyphs, 300, n_lines * 16 + 1, 4, 1, 1, n_threads ); }
+    free( dump_str );
+  }
+
+  return 0;
+}
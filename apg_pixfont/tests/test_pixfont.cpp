@@ -2,6 +2,7 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 #include <stdio.h>
+#include <string.h>
 
 #define N_TEST_STRINGS 7
 
@@ -49,6 +50,158 @@ int main() {
     free( text_img );
   }
 
+  // LAYOUT MUST MATCH THE ONE-SHOT FUNCTIONS
+  for ( int i = 0; i < N_TEST_STRINGS; i++ ) {
+    int w = 0, h = 0, lw = 0, lh = 0;
+    apg_pixfont_image_size_for_str( test_strings[i], &w, &h, thickness[i], outlines[i] );
+    apg_pixfont_layout_t* layout = apg_pixfont_layout_create( test_strings[i], thickness[i], outlines[i] );
+    if ( !layout || !apg_pixfont_layout_size( layout, &lw, &lh ) || lw != w || lh != h ) {
+      fprintf( stderr, "ERROR: layout size mismatch for string %i\n", i );
+      return 1;
+    }
+    unsigned char* a_img = (unsigned char*)calloc( 1, w * h * n_chans[i] );
+    unsigned char* b_img = (unsigned char*)calloc( 1, w * h * n_chans[i] );
+    apg_pixfont_str_into_image( test_strings[i], a_img, w, h, n_chans[i], 0xFF, 0x7F, 0x00, 0xFF, thickness[i], outlines[i] );
+    apg_pixfont_layout_into_image( layout, b_img, w, h, 0, 0, n_chans[i], 0xFF, 0x7F, 0x00, 0xFF );
+    if ( memcmp( a_img, b_img, w * h * n_chans[i] ) != 0 ) {
+      fprintf( stderr, "ERROR: layout image mismatch for string %i\n", i );
+      return 1;
+    }
+    free( a_img );
+    free( b_img );
+    apg_pixfont_layout_free( layout );
+  }
+
+  // BATCH ALL THE STRINGS INTO ONE ATLAS
+  {
+    apg_pixfont_rect_t rects[N_TEST_STRINGS];
+    int w = 0, h = 0;
+    unsigned char* atlas_img = apg_pixfont_strs_into_atlas( test_strings, N_TEST_STRINGS, rects, 256, &w, &h, 4, 0xFF, 0xFF, 0xFF, 0xFF, 1, true );
+    if ( !atlas_img ) {
+      fprintf( stderr, "ERROR: creating atlas image\n" );
+      return 1;
+    }
+    if ( !stbi_write_png( "atlas.png", w, h, 4, atlas_img, w * 4 ) ) {
+      fprintf( stderr, "ERROR: writing atlas image\n" );
+      return 1;
+    }
+    free( atlas_img );
+  }
+
+  // SDF ATLAS FOR GPU TEXT
+  {
+    apg_pixfont_glyph_metrics_t metrics[APG_PIXFONT_N_GLYPHS];
+    int w = 0, h = 0;
+    unsigned char* sdf_img = apg_pixfont_sdf_atlas( 4, 2, &w, &h, metrics );
+    if ( !sdf_img ) {
+      fprintf( stderr, "ERROR: creating SDF atlas\n" );
+      return 1;
+    }
+    int glyph = apg_pixfont_glyph_for_codepoint( 0xDF ); // small doppel S
+    if ( glyph < 0 || metrics[glyph].codepoint != 0xDF || metrics[apg_pixfont_glyph_for_codepoint( 'l' )].advance != 2 ) {
+      fprintf( stderr, "ERROR: SDF atlas glyph metrics\n" );
+      return 1;
+    }
+    if ( !stbi_write_png( "sdf.png", w, h, 1, sdf_img, w ) ) {
+      fprintf( stderr, "ERROR: writing SDF atlas image\n" );
+      return 1;
+    }
+    free( sdf_img );
+  }
+
+  // QUADS FOR GPU TEXT - drawn back into an image here from the atlas, which must match the CPU rasteriser
+  {
+    const char* str = test_strings[2];
+    int w = 0, h = 0;
+    apg_pixfont_image_size_for_str( str, &w, &h, 2, false );
+    unsigned char* cpu_img   = (unsigned char*)calloc( 1, w * h );
+    unsigned char* quad_img  = (unsigned char*)calloc( 1, w * h );
+    unsigned char* atlas_img = (unsigned char*)malloc( APG_PIXFONT_ATLAS_W * APG_PIXFONT_ATLAS_H );
+    apg_pixfont_str_into_image( str, cpu_img, w, h, 1, 0xFF, 0xFF, 0xFF, 0xFF, 2, false );
+    apg_pixfont_atlas_into_image( atlas_img );
+    apg_pixfont_quad_t quads[64];
+    int n_quads = apg_pixfont_str_to_quads( str, 0.0f, 0.0f, 2, quads, 64 );
+    if ( n_quads != apg_pixfont_str_to_quads( str, 0.0f, 0.0f, 2, NULL, 0 ) ) {
+      fprintf( stderr, "ERROR: counting quads\n" );
+      return 1;
+    }
+    for ( int q = 0; q < n_quads; q++ ) {
+      for ( int y = (int)quads[q].y0; y < (int)quads[q].y1; y++ ) {
+        for ( int x = (int)quads[q].x0; x < (int)quads[q].x1; x++ ) {
+          int u               = (int)( quads[q].u0 * APG_PIXFONT_ATLAS_W + 0.5f ) + ( x - (int)quads[q].x0 ) / 2;
+          int v               = ( y - (int)quads[q].y0 ) / 2;
+          quad_img[y * w + x] = atlas_img[v * APG_PIXFONT_ATLAS_W + u];
+        }
+      }
+    }
+    if ( memcmp( cpu_img, quad_img, w * h ) != 0 ) {
+      fprintf( stderr, "ERROR: quads don't match CPU image\n" );
+      return 1;
+    }
+    free( cpu_img );
+    free( quad_img );
+    free( atlas_img );
+  }
+
+  // DRAW INTO A CLIPPED, STRIDED TARGET - blended over a background, and copied, to find which pixels are text
+  {
+    const int w = 64, h = 40, stride = w * 4 + 16;
+    unsigned char* blend_img = (unsigned char*)malloc( stride * h );
+    unsigned char* copy_img  = (unsigned char*)malloc( stride * h );
+    memset( blend_img, 0x11, stride * h );
+    memset( copy_img, 0x11, stride * h );
+    apg_pixfont_target_t target = { blend_img, w, h, 4, stride, -3, 4, { 8, 8, 32, 16 }, APG_PIXFONT_BLEND_ALPHA };
+    apg_pixfont_str_into_target( "Hello\nWorld", &target, 0xFF, 0xFF, 0xFF, 0x80, 4, false );
+    target.image = copy_img;
+    target.blend = APG_PIXFONT_BLEND_NONE;
+    apg_pixfont_str_into_target( "Hello\nWorld", &target, 0xFF, 0xFF, 0xFF, 0x80, 4, false );
+    const unsigned char blended = ( 0xFF * 0x80 + 0x11 * 0x7F + 128 + ( ( 0xFF * 0x80 + 0x11 * 0x7F + 128 ) >> 8 ) ) >> 8;
+    int n_text_px = 0;
+    for ( int i = 0; i < stride * h; i++ ) {
+      int x = ( i % stride ) / 4, y = i / stride;
+      bool in_clip = i % stride < w * 4 && x >= 8 && x < 40 && y >= 8 && y < 24;
+      if ( !in_clip && ( blend_img[i] != 0x11 || copy_img[i] != 0x11 ) ) {
+        fprintf( stderr, "ERROR: target drawn outside clip rect at %i,%i\n", x, y );
+        return 1;
+      }
+      if ( copy_img[i] == 0xFF ) {
+        n_text_px++;
+        if ( blend_img[i] != blended ) {
+          fprintf( stderr, "ERROR: target blend %i != %i at %i,%i\n", blend_img[i], blended, x, y );
+          return 1;
+        }
+      }
+    }
+    if ( 0 == n_text_px ) {
+      fprintf( stderr, "ERROR: no text drawn into target\n" );
+      return 1;
+    }
+    free( blend_img );
+    free( copy_img );
+  }
+
+  // MULTI-THREADED BANDS MUST MATCH THE SERIAL RENDERER
+  {
+    char block[APG_PIXFONT_MAX_STRLEN];
+    int len = 0;
+    for ( int line = 0; line < 60; line++ ) { len += snprintf( &block[len], sizeof( block ) - len, "%i: log line {%i} ÄÖÜ.\n", line, line * 7 ); }
+    for ( int threads = 1; threads <= 8; threads *= 2 ) {
+      int w = 0, h = 0;
+      apg_pixfont_image_size_for_str( block, &w, &h, 2, true );
+      h -= 21; // cut the last line in half
+      unsigned char* serial_img = (unsigned char*)calloc( 1, w * h * 4 );
+      unsigned char* mt_img     = (unsigned char*)calloc( 1, w * h * 4 );
+      apg_pixfont_str_into_image( block, serial_img, w, h, 4, 0xFF, 0x7F, 0x00, 0xFF, 2, true );
+      apg_pixfont_str_into_image_mt( block, mt_img, w, h, 4, 0xFF, 0x7F, 0x00, 0xFF, 2, true, threads );
+      if ( memcmp( serial_img, mt_img, w * h * 4 ) != 0 ) {
+        fprintf( stderr, "ERROR: multi-threaded render with %i threads doesn't match serial\n", threads );
+        return 1;
+      }
+      free( serial_img );
+      free( mt_img );
+    }
+  }
+
   // convert a font image file to C array for pasting into apg_pixfont.c
 #ifdef GENERATE_C_ARRAY_FONT
   {
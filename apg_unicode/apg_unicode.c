@@ -1,19 +1,33 @@
 /* apg_unicode
 Unicode <-> UTF-8 Multibyte String Functions for C & C++
 Anton Gerdelan
-Version: 0.2. 3 May 2020.
+Version: 0.6. 18 Oct 2026.
 Licence: see apg_unicode.h
 C99
 */
 
 #include "apg_unicode.h"
 #include <assert.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-#define APG_UNICODE_MAX_STR 2048 // max length of string. for avoiding infinite loops.
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define _APG_UNICODE_SSE2
+#if defined( __SSSE3__ ) || defined( __AVX__ ) // MSVC only defines a macro for SSSE3 when compiling for AVX or later
+#include <tmmintrin.h>
+#define _APG_UNICODE_SSSE3
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#define _APG_UNICODE_AVX2
+#endif
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define _APG_UNICODE_NEON
+#endif
 
 // clang-format off
 #define MASK_FIRST_ONE   128 // 128 or 10000000
@@ -87,13 +101,13 @@ uint32_t apg_utf8_to_cp( const char* mbs, int* sz ) {
     return (uint32_t)mbs[0];
   }
 
+  // 10xxxxxx is a continuation byte, and can't start a sequence
+  if ( first_byte < MASK_FIRST_TWO ) { return 0; }
+
   // 2 bytes: 110xxxxx 10xxxxxx - 11 bits for cp (U+0080 to U+07FF - Latin, Greek, Hebrew, Arabic, ... )
   if ( first_byte < MASK_FIRST_THREE ) {
     uint8_t second_byte = (uint8_t)mbs[1];
-    if ( second_byte < MASK_FIRST_ONE || second_byte >= MASK_FIRST_TWO ) {
-      fprintf( stderr, "ERROR: invalid utf-8 byte - second byte of sequence\n" );
-      return 0;
-    }
+    if ( second_byte < MASK_FIRST_ONE || second_byte >= MASK_FIRST_TWO ) { return 0; }
     uint8_t part_a     = first_byte << 3;             // shift 110xxxxx to xxxxx000
     uint8_t part_b     = second_byte & (uint8_t)0x3F; // & with 0x3F (binary 00111111) to zero the first two bits from 10xxxxxx
     uint32_t codepoint = (uint32_t)part_a << 3;       // 00000000 00000000 00000000 xxxxx000 << 3 = 00000000 00000000 00000xxx xx000000
@@ -105,25 +119,16 @@ uint32_t apg_utf8_to_cp( const char* mbs, int* sz ) {
   // 3 bytes: 1110xxxx 10xxxxxx 10xxxxxx - 16 bits for cp - U+0800  to U+FFFF (most CJK)
   if ( first_byte < MASK_FIRST_FOUR ) {
     uint8_t second_byte = (uint8_t)mbs[1];
-    if ( second_byte < MASK_FIRST_ONE || second_byte >= MASK_FIRST_TWO ) {
-      fprintf( stderr, "ERROR: invalid utf-8 byte - second byte of sequence\n" );
-      return 0;
-    }
+    if ( second_byte < MASK_FIRST_ONE || second_byte >= MASK_FIRST_TWO ) { return 0; }
     uint8_t third_byte = (uint8_t)mbs[2];
-    if ( third_byte < MASK_FIRST_ONE || third_byte >= MASK_FIRST_TWO ) {
-      fprintf( stderr, "ERROR: invalid utf-8 byte - third byte of sequence\n" );
-      return 0;
-    }
-    // TODO(Anton) check why part_b and part_c aren't used here
-    uint8_t part_a = first_byte << 4;             // shift 1110xxxx to xxxx0000
+    if ( third_byte < MASK_FIRST_ONE || third_byte >= MASK_FIRST_TWO ) { return 0; }
+    uint8_t part_a = first_byte & (uint8_t)0x0F;  // & with 0x0F (binary 00001111) to zero the first four bits from 1110xxxx
     uint8_t part_b = second_byte & (uint8_t)0x3F; // & with 0x3F (binary 00111111) to zero the first two bits from 10xxxxxx
     uint8_t part_c = third_byte & (uint8_t)0x3F;  // & with 0x3F (binary 00111111) to zero the first two bits from 10xxxxxx
-    // 00000000 00000000 00000000 xxxx0000 << 2 = 00000000 00000000 000000xx xx000000
-    uint32_t codepoint = (uint32_t)part_a << 2;
-    // 00000000 00000000 000000xx xx000000 | pb = 00000000 00000000 000000xx xxxxxxxx, << 6 = 00000000 00000000 xxxxxxxx xx000000
-    codepoint = ( codepoint | (uint32_t)second_byte ) << 6;
-    // 00000000 00000000 000000xx xx000000 | pc = 00000000 00000000 xxxxxxxx xxxxxxxx
-    codepoint |= (uint32_t)third_byte;
+    // 00000000 00000000 00000000 0000xxxx << 6 | pb = 00000000 00000000 000000xx xxxxxxxx
+    uint32_t codepoint = ( (uint32_t)part_a << 6 ) | (uint32_t)part_b;
+    // 00000000 00000000 000000xx xxxxxxxx << 6 | pc = 00000000 00000000 xxxxxxxx xxxxxxxx
+    codepoint = ( codepoint << 6 ) | (uint32_t)part_c;
     *sz = 3;
     return codepoint;
   }
@@ -132,75 +137,582 @@ uint32_t apg_utf8_to_cp( const char* mbs, int* sz ) {
   // 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
   if ( first_byte < MASK_FIRST_FIVE ) {
     uint8_t second_byte = (uint8_t)mbs[1];
-    if ( second_byte < MASK_FIRST_ONE || second_byte >= MASK_FIRST_TWO ) {
-      fprintf( stderr, "ERROR: invalid utf-8 byte - second byte of sequence\n" );
-      return 0;
-    }
+    if ( second_byte < MASK_FIRST_ONE || second_byte >= MASK_FIRST_TWO ) { return 0; }
     uint8_t third_byte = (uint8_t)mbs[2];
-    if ( third_byte < MASK_FIRST_ONE || third_byte >= MASK_FIRST_TWO ) {
-      fprintf( stderr, "ERROR: invalid utf-8 byte - third byte of sequence\n" );
-      return 0;
-    }
+    if ( third_byte < MASK_FIRST_ONE || third_byte >= MASK_FIRST_TWO ) { return 0; }
     uint8_t fourth_byte = (uint8_t)mbs[3];
-    if ( fourth_byte < MASK_FIRST_ONE || fourth_byte >= MASK_FIRST_TWO ) {
-      fprintf( stderr, "ERROR: invalid utf-8 byte - fourth byte of sequence\n" );
-      return 0;
-    }
-    uint8_t part_a = first_byte << 4;             // shift 1110xxxx to xxxx0000
+    if ( fourth_byte < MASK_FIRST_ONE || fourth_byte >= MASK_FIRST_TWO ) { return 0; }
+    uint8_t part_a = first_byte & (uint8_t)0x07;  // & with 0x07 (binary 00000111) to zero the first five bits from 11110xxx
     uint8_t part_b = second_byte & (uint8_t)0x3F; // & with 0x3F (binary 00111111) to zero the first two bits from 10xxxxxx
     uint8_t part_c = third_byte & (uint8_t)0x3F;  // & with 0x3F (binary 00111111) to zero the first two bits from 10xxxxxx
     uint8_t part_d = fourth_byte & (uint8_t)0x3F; // & with 0x3F (binary 00111111) to zero the first two bits from 10xxxxxx
-    // 00000000 00000000 00000000 xxx00000 << 1 = 00000000 00000000 0000000x xx000000
-    uint32_t codepoint = (uint32_t)part_a << 1;
-    // 00000000 00000000 0000000x xx000000 | pb = 00000000 00000000 0000000x xxxxxxxx, << 6 = 00000000 00000000 0xxxxxxx xx000000
-    codepoint = ( codepoint | (uint32_t)part_b ) << 6;
-    // 00000000 00000000 0xxxxxxx xx000000 | pc = 00000000 00000000 0xxxxxxx xxxxxxxx, << 6 = 00000000 000xxxxx xxxxxxxx xx000000
-    codepoint = ( codepoint | (uint32_t)part_c ) << 6;
-    // 00000000 000xxxxx xxxxxxxx xx000000 | pc = 00000000 000xxxxx xxxxxxxx xxxxxxxx
-    codepoint |= (uint32_t)part_d;
+    // 00000000 00000000 00000000 00000xxx << 6 | pb = 00000000 00000000 0000000x xxxxxxxx
+    uint32_t codepoint = ( (uint32_t)part_a << 6 ) | (uint32_t)part_b;
+    // 00000000 00000000 0000000x xxxxxxxx << 6 | pc = 00000000 00000000 0xxxxxxx xxxxxxxx
+    codepoint = ( codepoint << 6 ) | (uint32_t)part_c;
+    // 00000000 00000000 0xxxxxxx xxxxxxxx << 6 | pd = 00000000 000xxxxx xxxxxxxx xxxxxxxx
+    codepoint = ( codepoint << 6 ) | (uint32_t)part_d;
     *sz = 4;
     return codepoint;
   }
 
-  fprintf( stderr, "ERROR: invalid utf-8 byte - first byte of sequence\n" );
   return 0;
 }
 
+/* Strict decoding of one UTF-8 sequence, as used by apg_utf8_validate() and apg_utf8_decode(). Unlike apg_utf8_to_cp() this rejects overlong encodings,
+surrogates (U+D800 to U+DFFF), codepoints above U+10FFFF, and sequences cut off by the end of the buffer.
+RETURNS the number of bytes in the sequence (1 - 4), or 0 if the bytes at s are not a valid sequence. */
+static int _decode_seq( const uint8_t* s, size_t len, uint32_t* cp ) {
+  uint8_t first_byte = s[0];
+  if ( first_byte < MASK_FIRST_ONE ) {
+    *cp = first_byte;
+    return 1;
+  }
+  if ( first_byte < 0xC2 ) { return 0; } // continuation byte, or 0xC0 and 0xC1 which could only start overlong 2-byte sequences
+  if ( first_byte < MASK_FIRST_THREE ) {
+    if ( len < 2 || ( s[1] & MASK_FIRST_TWO ) != MASK_FIRST_ONE ) { return 0; }
+    *cp = ( (uint32_t)( first_byte & 0x1F ) << 6 ) | (uint32_t)( s[1] & 0x3F );
+    return 2;
+  }
+  // the valid range of the second byte of 3 and 4-byte sequences depends on the first byte
+  uint8_t second_min = 0x80, second_max = 0xBF;
+  if ( first_byte < MASK_FIRST_FOUR ) {
+    if ( 0xE0 == first_byte ) { second_min = 0xA0; } // overlong
+    if ( 0xED == first_byte ) { second_max = 0x9F; } // surrogates
+    if ( len < 3 || s[1] < second_min || s[1] > second_max || ( s[2] & MASK_FIRST_TWO ) != MASK_FIRST_ONE ) { return 0; }
+    *cp = ( (uint32_t)( first_byte & 0x0F ) << 12 ) | ( (uint32_t)( s[1] & 0x3F ) << 6 ) | (uint32_t)( s[2] & 0x3F );
+    return 3;
+  }
+  if ( first_byte < 0xF5 ) {
+    if ( 0xF0 == first_byte ) { second_min = 0x90; } // overlong
+    if ( 0xF4 == first_byte ) { second_max = 0x8F; } // above U+10FFFF
+    if ( len < 4 || s[1] < second_min || s[1] > second_max || ( s[2] & MASK_FIRST_TWO ) != MASK_FIRST_ONE ||
+         ( s[3] & MASK_FIRST_TWO ) != MASK_FIRST_ONE ) {
+      return 0;
+    }
+    *cp = ( (uint32_t)( first_byte & 0x07 ) << 18 ) | ( (uint32_t)( s[1] & 0x3F ) << 12 ) | ( (uint32_t)( s[2] & 0x3F ) << 6 ) | (uint32_t)( s[3] & 0x3F );
+    return 4;
+  }
+  return 0; // 0xF5 to 0xFF only start sequences above U+10FFFF, or longer than 4 bytes
+}
+
+#ifdef _APG_UNICODE_NEON
+// RETURNS true if any byte in v is 128 or more, i.e. not ASCII.
+static bool _any_high_bit_neon( uint8x16_t v ) {
+  uint8x8_t halves = vorr_u8( vget_low_u8( v ), vget_high_u8( v ) );
+  return 0 != ( vget_lane_u64( vreinterpret_u64_u8( halves ), 0 ) & 0x8080808080808080ULL );
+}
+#endif
+
+// Validates from byte `i`, which must start a sequence, to the end. Runs of ASCII are skipped 32 bytes at a time where there is SIMD support.
+static size_t _validate_from( const uint8_t* s, size_t len, size_t i ) {
+  while ( i < len ) {
+#if defined( _APG_UNICODE_SSE2 )
+    if ( i + 32 <= len ) {
+      __m128i bytes = _mm_or_si128( _mm_loadu_si128( (const __m128i*)&s[i] ), _mm_loadu_si128( (const __m128i*)&s[i + 16] ) );
+      if ( 0 == _mm_movemask_epi8( bytes ) ) {
+        i += 32;
+        continue;
+      }
+    }
+#elif defined( _APG_UNICODE_NEON )
+    if ( i + 32 <= len ) {
+      if ( !_any_high_bit_neon( vorrq_u8( vld1q_u8( &s[i] ), vld1q_u8( &s[i + 16] ) ) ) ) {
+        i += 32;
+        continue;
+      }
+    }
+#endif
+    uint32_t cp = 0;
+    int nbytes  = _decode_seq( &s[i], len - i, &cp );
+    if ( 0 == nbytes ) { return i; }
+    i += nbytes;
+  }
+  return len;
+}
+
+/* RETURNS a position to resume scalar validation from, before block boundary `i`, given that all of the bytes before `i` are valid UTF-8 apart from perhaps a
+sequence that is cut off by the boundary. That sequence must start at the last non-continuation byte in the 3 bytes before `i`, if there is one. */
+static size_t _start_of_seq( const uint8_t* s, size_t i ) {
+  for ( size_t j = i; j > 0 && i - j < 3; j-- ) {
+    if ( ( s[j - 1] & MASK_FIRST_TWO ) != MASK_FIRST_ONE ) { return j - 1; }
+  }
+  return i;
+}
+
+#ifdef _APG_UNICODE_SSSE3
+/* Validation of 16 bytes at a time with the lookup tables of J. Keiser and D. Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte" (2021).
+Each bit in a table entry is one kind of error. An error is found where a bit is set for the high nibble of the previous byte, the low nibble of the previous
+byte, and the high nibble of the current byte. Bytes that must be the 2nd continuation of a 3-byte sequence, or the 2nd or 3rd of a 4-byte sequence, are
+checked separately. */
+// clang-format off
+#define _TOO_SHORT      ( 1 << 0 ) // 11______ 0_______ or 11______ 11______
+#define _TOO_LONG       ( 1 << 1 ) // 0_______ 10______
+#define _OVERLONG_3     ( 1 << 2 ) // 11100000 100_____
+#define _TOO_LARGE      ( 1 << 3 ) // 11110100 1001____ or 11110100 101_____ or 11110101+ 1001____ or 11110101+ 101_____
+#define _SURROGATE      ( 1 << 4 ) // 11101101 101_____
+#define _OVERLONG_2     ( 1 << 5 ) // 1100000_ 10______
+#define _TOO_LARGE_1000 ( 1 << 6 ) // 11110101+ 1000____
+#define _OVERLONG_4     ( 1 << 6 ) // 11110000 1000____
+#define _TWO_CONTS      ( 1 << 7 ) // 10______ 10______
+#define _CARRY          ( _TOO_SHORT | _TOO_LONG | _TWO_CONTS )
+static const uint8_t _byte_1_high_table[16] = {
+  _TOO_LONG, _TOO_LONG, _TOO_LONG, _TOO_LONG, _TOO_LONG, _TOO_LONG, _TOO_LONG, _TOO_LONG, // 0_______ ASCII
+  _TWO_CONTS, _TWO_CONTS, _TWO_CONTS, _TWO_CONTS,                                         // 10______ continuation
+  _TOO_SHORT | _OVERLONG_2,                                                               // 1100____ 2-byte lead
+  _TOO_SHORT,                                                                             // 1101____ 2-byte lead
+  _TOO_SHORT | _OVERLONG_3 | _SURROGATE,                                                  // 1110____ 3-byte lead
+  _TOO_SHORT | _TOO_LARGE | _TOO_LARGE_1000 | _OVERLONG_4                                 // 1111____ 4-byte lead
+};
+static const uint8_t _byte_1_low_table[16] = {
+  _CARRY | _OVERLONG_3 | _OVERLONG_2 | _OVERLONG_4,              // ____0000
+  _CARRY | _OVERLONG_2,                                          // ____0001
+  _CARRY, _CARRY,                                                // ____001_
+  _CARRY | _TOO_LARGE,                                           // ____0100
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000,                         // ____0101
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000,                         // ____0110
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000,                         // ____0111
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000,                         // ____1000
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000,                         // ____1001
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000,                         // ____1010
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000,                         // ____1011
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000,                         // ____1100
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000 | _SURROGATE,            // ____1101
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000,                         // ____1110
+  _CARRY | _TOO_LARGE | _TOO_LARGE_1000                          // ____1111
+};
+static const uint8_t _byte_2_high_table[16] = {
+  _TOO_SHORT, _TOO_SHORT, _TOO_SHORT, _TOO_SHORT, _TOO_SHORT, _TOO_SHORT, _TOO_SHORT, _TOO_SHORT,            // 0_______ ASCII
+  _TOO_LONG | _OVERLONG_2 | _TWO_CONTS | _OVERLONG_3 | _TOO_LARGE_1000 | _OVERLONG_4,                        // 1000____
+  _TOO_LONG | _OVERLONG_2 | _TWO_CONTS | _OVERLONG_3 | _TOO_LARGE,                                           // 1001____
+  _TOO_LONG | _OVERLONG_2 | _TWO_CONTS | _SURROGATE | _TOO_LARGE,                                            // 1010____
+  _TOO_LONG | _OVERLONG_2 | _TWO_CONTS | _SURROGATE | _TOO_LARGE,                                            // 1011____
+  _TOO_SHORT, _TOO_SHORT, _TOO_SHORT, _TOO_SHORT                                                             // 11______ lead
+};
+// a block ends part-way through a sequence if its last byte is a lead, 2nd last is a 3 or 4-byte lead, or 3rd last is a 4-byte lead
+static const uint8_t _incomplete_max[16] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1 };
+// clang-format on
+
+// RETURNS non-zero bytes where there are errors in `input`, or sequences that start in the last 3 bytes of `prev_input`.
+static __m128i _check_block_ssse3( __m128i input, __m128i prev_input ) {
+  const __m128i low_nibble_mask = _mm_set1_epi8( 0x0F );
+  __m128i prev1                 = _mm_alignr_epi8( input, prev_input, 15 ); // the byte before each byte of input
+  __m128i byte_1_high = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)_byte_1_high_table ), _mm_and_si128( _mm_srli_epi16( prev1, 4 ), low_nibble_mask ) );
+  __m128i byte_1_low  = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)_byte_1_low_table ), _mm_and_si128( prev1, low_nibble_mask ) );
+  __m128i byte_2_high = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)_byte_2_high_table ), _mm_and_si128( _mm_srli_epi16( input, 4 ), low_nibble_mask ) );
+  __m128i special_cases = _mm_and_si128( _mm_and_si128( byte_1_high, byte_1_low ), byte_2_high );
+
+  // top bit set where the byte 2 back is a 3 or 4-byte lead, or the byte 3 back is a 4-byte lead. those bytes must be continuations, which is the one case
+  // where _TWO_CONTS is not an error.
+  __m128i prev2 = _mm_alignr_epi8( input, prev_input, 14 );
+  __m128i prev3 = _mm_alignr_epi8( input, prev_input, 13 );
+  __m128i must_be_cont = _mm_or_si128( _mm_subs_epu8( prev2, _mm_set1_epi8( (char)( 0xE0 - 0x80 ) ) ), _mm_subs_epu8( prev3, _mm_set1_epi8( (char)( 0xF0 - 0x80 ) ) ) );
+  return _mm_xor_si128( _mm_and_si128( must_be_cont, _mm_set1_epi8( (char)0x80 ) ), special_cases );
+}
+#endif
+
+size_t apg_utf8_validate( const char* buf, size_t len ) {
+  assert( buf || 0 == len );
+  if ( !buf ) { return 0; }
+  const uint8_t* s = (const uint8_t*)buf;
+  size_t i         = 0;
+
+#ifdef _APG_UNICODE_SSSE3
+  const __m128i zero       = _mm_setzero_si128();
+  __m128i prev_input       = zero;
+  __m128i prev_incomplete  = zero;
+  const __m128i incomplete_max = _mm_loadu_si128( (const __m128i*)_incomplete_max );
+  for ( ; i + 16 <= len; i += 16 ) {
+    __m128i input = _mm_loadu_si128( (const __m128i*)&s[i] );
+    __m128i error = prev_incomplete; // an ASCII block only has errors if the previous block ended part-way through a sequence
+    if ( 0 != _mm_movemask_epi8( input ) ) {
+      error           = _check_block_ssse3( input, prev_input );
+      prev_incomplete = _mm_subs_epu8( input, incomplete_max );
+    } else {
+      prev_incomplete = zero;
+    }
+    // find the exact position of the error with the scalar validator. everything before this block is valid, so start at the sequence straddling it.
+    if ( 0xFFFF != _mm_movemask_epi8( _mm_cmpeq_epi8( error, zero ) ) ) { return _validate_from( s, len, _start_of_seq( s, i ) ); }
+    prev_input = input;
+  }
+#endif
+
+  return _validate_from( s, len, _start_of_seq( s, i ) );
+}
+
+size_t apg_utf8_decode( const char* buf, size_t len, uint32_t* out, size_t* error_pos ) {
+  assert( ( buf && out ) || 0 == len );
+  size_t i = 0, n_cps = 0;
+  if ( !buf || !out ) { len = 0; }
+  const uint8_t* s = (const uint8_t*)buf;
+
+  while ( i < len ) {
+    // runs of ASCII are widened to codepoints 16 at a time
+#if defined( _APG_UNICODE_SSE2 )
+    if ( i + 16 <= len ) {
+      __m128i bytes = _mm_loadu_si128( (const __m128i*)&s[i] );
+      if ( 0 == _mm_movemask_epi8( bytes ) ) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i low_half   = _mm_unpacklo_epi8( bytes, zero );
+        __m128i high_half  = _mm_unpackhi_epi8( bytes, zero );
+        _mm_storeu_si128( (__m128i*)&out[n_cps], _mm_unpacklo_epi16( low_half, zero ) );
+        _mm_storeu_si128( (__m128i*)&out[n_cps + 4], _mm_unpackhi_epi16( low_half, zero ) );
+        _mm_storeu_si128( (__m128i*)&out[n_cps + 8], _mm_unpacklo_epi16( high_half, zero ) );
+        _mm_storeu_si128( (__m128i*)&out[n_cps + 12], _mm_unpackhi_epi16( high_half, zero ) );
+        i += 16;
+        n_cps += 16;
+        continue;
+      }
+    }
+#elif defined( _APG_UNICODE_NEON )
+    if ( i + 16 <= len ) {
+      uint8x16_t bytes = vld1q_u8( &s[i] );
+      if ( !_any_high_bit_neon( bytes ) ) {
+        uint16x8_t low_half  = vmovl_u8( vget_low_u8( bytes ) );
+        uint16x8_t high_half = vmovl_u8( vget_high_u8( bytes ) );
+        vst1q_u32( &out[n_cps], vmovl_u16( vget_low_u16( low_half ) ) );
+        vst1q_u32( &out[n_cps + 4], vmovl_u16( vget_high_u16( low_half ) ) );
+        vst1q_u32( &out[n_cps + 8], vmovl_u16( vget_low_u16( high_half ) ) );
+        vst1q_u32( &out[n_cps + 12], vmovl_u16( vget_high_u16( high_half ) ) );
+        i += 16;
+        n_cps += 16;
+        continue;
+      }
+    }
+#endif
+    int nbytes = _decode_seq( &s[i], len - i, &out[n_cps] );
+    if ( 0 == nbytes ) { break; }
+    i += nbytes;
+    n_cps++;
+  }
+  if ( error_pos ) { *error_pos = i; }
+  return n_cps;
+}
+
+// Writes the UTF-8 sequence for a codepoint, without a nul terminator. Surrogates and codepoints above U+10FFFF are written as U+FFFD.
+// RETURNS the number of bytes in the sequence (1 - 4).
+static int _encode_cp( uint32_t cp, uint8_t* mbs ) {
+  if ( ( cp >= 0xD800 && cp <= 0xDFFF ) || cp > 0x10FFFF ) { cp = 0xFFFD; }
+  if ( cp < 0x80 ) {
+    mbs[0] = (uint8_t)cp;
+    return 1;
+  }
+  if ( cp < 0x0800 ) {
+    mbs[0] = (uint8_t)( ( cp >> 6 ) | MASK_FIRST_TWO );
+    mbs[1] = (uint8_t)( ( cp & 0x3F ) | MASK_FIRST_ONE );
+    return 2;
+  }
+  if ( cp < 0x10000 ) {
+    mbs[0] = (uint8_t)( ( cp >> 12 ) | MASK_FIRST_THREE );
+    mbs[1] = (uint8_t)( ( ( cp >> 6 ) & 0x3F ) | MASK_FIRST_ONE );
+    mbs[2] = (uint8_t)( ( cp & 0x3F ) | MASK_FIRST_ONE );
+    return 3;
+  }
+  mbs[0] = (uint8_t)( ( cp >> 18 ) | MASK_FIRST_FOUR );
+  mbs[1] = (uint8_t)( ( ( cp >> 12 ) & 0x3F ) | MASK_FIRST_ONE );
+  mbs[2] = (uint8_t)( ( ( cp >> 6 ) & 0x3F ) | MASK_FIRST_ONE );
+  mbs[3] = (uint8_t)( ( cp & 0x3F ) | MASK_FIRST_ONE );
+  return 4;
+}
+
+/* Appends the UTF-8 sequence for a codepoint to out at *n_bytes, if it fits in out_sz and everything before it did, and counts its bytes either way.
+*n_out is the number of bytes written, which stops growing once a sequence doesn't fit, so that the output is always whole sequences from the start of the
+input. Writing has stopped when *n_out != *n_bytes. */
+static void _append_cp_utf8( uint32_t cp, uint8_t* out, size_t out_sz, size_t* n_bytes, size_t* n_out ) {
+  if ( *n_out == *n_bytes && *n_bytes + 4 <= out_sz ) {
+    *n_bytes += _encode_cp( cp, &out[*n_bytes] );
+    *n_out = *n_bytes;
+    return;
+  }
+  uint8_t mbs[4];
+  int nbytes = _encode_cp( cp, mbs );
+  if ( *n_out == *n_bytes && *n_bytes + nbytes <= out_sz ) {
+    memcpy( &out[*n_bytes], mbs, nbytes );
+    *n_out += nbytes;
+  }
+  *n_bytes += nbytes;
+}
+
+size_t apg_utf32_to_utf8( const uint32_t* in, size_t n_cps, char* out, size_t out_sz, size_t* n_written ) {
+  assert( in || 0 == n_cps );
+  if ( !in ) { n_cps = 0; }
+  if ( !out ) { out_sz = 0; }
+  uint8_t* dst   = (uint8_t*)out;
+  size_t n_bytes = 0, n_out = 0, i = 0;
+
+  while ( i < n_cps ) {
+    // runs of ASCII are narrowed to bytes 16 at a time
+#if defined( _APG_UNICODE_SSE2 )
+    if ( i + 16 <= n_cps ) {
+      __m128i a = _mm_loadu_si128( (const __m128i*)&in[i] ), b = _mm_loadu_si128( (const __m128i*)&in[i + 4] );
+      __m128i c = _mm_loadu_si128( (const __m128i*)&in[i + 8] ), d = _mm_loadu_si128( (const __m128i*)&in[i + 12] );
+      __m128i high_bits = _mm_and_si128( _mm_or_si128( _mm_or_si128( a, b ), _mm_or_si128( c, d ) ), _mm_set1_epi32( ~0x7F ) );
+      // a block that only partly fits is left to the per-codepoint path below, which writes as much of it as fits
+      if ( 0xFFFF == _mm_movemask_epi8( _mm_cmpeq_epi32( high_bits, _mm_setzero_si128() ) ) && ( n_out < n_bytes || n_bytes + 16 <= out_sz ) ) {
+        if ( n_out == n_bytes ) {
+          _mm_storeu_si128( (__m128i*)&dst[n_bytes], _mm_packus_epi16( _mm_packs_epi32( a, b ), _mm_packs_epi32( c, d ) ) );
+          n_out += 16;
+        }
+        n_bytes += 16;
+        i += 16;
+        continue;
+      }
+    }
+#elif defined( _APG_UNICODE_NEON )
+    if ( i + 16 <= n_cps ) {
+      uint32x4_t a = vld1q_u32( &in[i] ), b = vld1q_u32( &in[i + 4] ), c = vld1q_u32( &in[i + 8] ), d = vld1q_u32( &in[i + 12] );
+      uint32x4_t high_bits = vandq_u32( vorrq_u32( vorrq_u32( a, b ), vorrq_u32( c, d ) ), vdupq_n_u32( ~0x7Fu ) );
+      if ( 0 == vget_lane_u64( vreinterpret_u64_u32( vorr_u32( vget_low_u32( high_bits ), vget_high_u32( high_bits ) ) ), 0 ) &&
+           ( n_out < n_bytes || n_bytes + 16 <= out_sz ) ) {
+        if ( n_out == n_bytes ) {
+          uint8x8_t low_half  = vmovn_u16( vcombine_u16( vmovn_u32( a ), vmovn_u32( b ) ) );
+          uint8x8_t high_half = vmovn_u16( vcombine_u16( vmovn_u32( c ), vmovn_u32( d ) ) );
+          vst1q_u8( &dst[n_bytes], vcombine_u8( low_half, high_half ) );
+          n_out += 16;
+        }
+        n_bytes += 16;
+        i += 16;
+        continue;
+      }
+    }
+#endif
+    _append_cp_utf8( in[i], dst, out_sz, &n_bytes, &n_out );
+    i++;
+  }
+  if ( n_written ) { *n_written = n_out; }
+  return n_bytes;
+}
+
+size_t apg_utf16_to_utf8( const uint16_t* in, size_t n_units, char* out, size_t out_sz, size_t* n_written, size_t* error_pos ) {
+  assert( in || 0 == n_units );
+  if ( !in ) { n_units = 0; }
+  if ( !out ) { out_sz = 0; }
+  uint8_t* dst   = (uint8_t*)out;
+  size_t n_bytes = 0, n_out = 0, i = 0;
+
+  while ( i < n_units ) {
+    // runs of ASCII are narrowed to bytes 16 at a time
+#if defined( _APG_UNICODE_SSE2 )
+    if ( i + 16 <= n_units ) {
+      __m128i a = _mm_loadu_si128( (const __m128i*)&in[i] ), b = _mm_loadu_si128( (const __m128i*)&in[i + 8] );
+      __m128i high_bits = _mm_and_si128( _mm_or_si128( a, b ), _mm_set1_epi16( ~0x7F ) );
+      if ( 0xFFFF == _mm_movemask_epi8( _mm_cmpeq_epi16( high_bits, _mm_setzero_si128() ) ) && ( n_out < n_bytes || n_bytes + 16 <= out_sz ) ) {
+        if ( n_out == n_bytes ) {
+          _mm_storeu_si128( (__m128i*)&dst[n_bytes], _mm_packus_epi16( a, b ) );
+          n_out += 16;
+        }
+        n_bytes += 16;
+        i += 16;
+        continue;
+      }
+    }
+#elif defined( _APG_UNICODE_NEON )
+    if ( i + 16 <= n_units ) {
+      uint16x8_t a = vld1q_u16( &in[i] ), b = vld1q_u16( &in[i + 8] );
+      uint16x8_t high_bits = vandq_u16( vorrq_u16( a, b ), vdupq_n_u16( (uint16_t)~0x7Fu ) );
+      if ( 0 == vget_lane_u64( vreinterpret_u64_u16( vorr_u16( vget_low_u16( high_bits ), vget_high_u16( high_bits ) ) ), 0 ) &&
+           ( n_out < n_bytes || n_bytes + 16 <= out_sz ) ) {
+        if ( n_out == n_bytes ) {
+          vst1q_u8( &dst[n_bytes], vcombine_u8( vmovn_u16( a ), vmovn_u16( b ) ) );
+          n_out += 16;
+        }
+        n_bytes += 16;
+        i += 16;
+        continue;
+      }
+    }
+#endif
+    uint32_t cp = in[i];
+    int n_cp_units = 1;
+    if ( cp >= 0xD800 && cp <= 0xDBFF ) { // a high surrogate must be followed by a low surrogate
+      if ( i + 1 >= n_units || in[i + 1] < 0xDC00 || in[i + 1] > 0xDFFF ) { break; }
+      cp         = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( (uint32_t)in[i + 1] - 0xDC00 );
+      n_cp_units = 2;
+    } else if ( cp >= 0xDC00 && cp <= 0xDFFF ) { // low surrogate without a high surrogate
+      break;
+    }
+    _append_cp_utf8( cp, dst, out_sz, &n_bytes, &n_out );
+    i += n_cp_units;
+  }
+  if ( n_written ) { *n_written = n_out; }
+  if ( error_pos ) { *error_pos = i; }
+  return n_bytes;
+}
+
+size_t apg_utf8_to_utf16( const char* in, size_t len, uint16_t* out, size_t out_units, size_t* n_written, size_t* error_pos ) {
+  assert( in || 0 == len );
+  if ( !in ) { len = 0; }
+  if ( !out ) { out_units = 0; }
+  const uint8_t* s = (const uint8_t*)in;
+  size_t n_units = 0, n_out = 0, i = 0;
+
+  while ( i < len ) {
+    // runs of ASCII are widened to 16-bit units 16 at a time
+#if defined( _APG_UNICODE_SSE2 )
+    if ( i + 16 <= len ) {
+      __m128i bytes = _mm_loadu_si128( (const __m128i*)&s[i] );
+      if ( 0 == _mm_movemask_epi8( bytes ) && ( n_out < n_units || n_units + 16 <= out_units ) ) {
+        if ( n_out == n_units ) {
+          _mm_storeu_si128( (__m128i*)&out[n_units], _mm_unpacklo_epi8( bytes, _mm_setzero_si128() ) );
+          _mm_storeu_si128( (__m128i*)&out[n_units + 8], _mm_unpackhi_epi8( bytes, _mm_setzero_si128() ) );
+          n_out += 16;
+        }
+        n_units += 16;
+        i += 16;
+        continue;
+      }
+    }
+#elif defined( _APG_UNICODE_NEON )
+    if ( i + 16 <= len ) {
+      uint8x16_t bytes = vld1q_u8( &s[i] );
+      if ( !_any_high_bit_neon( bytes ) && ( n_out < n_units || n_units + 16 <= out_units ) ) {
+        if ( n_out == n_units ) {
+          vst1q_u16( &out[n_units], vmovl_u8( vget_low_u8( bytes ) ) );
+          vst1q_u16( &out[n_units + 8], vmovl_u8( vget_high_u8( bytes ) ) );
+          n_out += 16;
+        }
+        n_units += 16;
+        i += 16;
+        continue;
+      }
+    }
+#endif
+    uint32_t cp = 0;
+    int nbytes  = _decode_seq( &s[i], len - i, &cp );
+    if ( 0 == nbytes ) { break; }
+    int n_cp_units = cp < 0x10000 ? 1 : 2; // codepoints above U+FFFF are split into a high and low surrogate pair
+    if ( n_out == n_units && n_units + n_cp_units <= out_units ) {
+      if ( 1 == n_cp_units ) {
+        out[n_units] = (uint16_t)cp;
+      } else {
+        out[n_units]     = (uint16_t)( 0xD800 + ( ( cp - 0x10000 ) >> 10 ) );
+        out[n_units + 1] = (uint16_t)( 0xDC00 + ( ( cp - 0x10000 ) & 0x3FF ) );
+      }
+      n_out += n_cp_units;
+    }
+    n_units += n_cp_units;
+    i += nbytes;
+  }
+  if ( n_written ) { *n_written = n_out; }
+  if ( error_pos ) { *error_pos = i; }
+  return n_units;
+}
+
+#if defined( _APG_UNICODE_SSE2 ) || defined( _APG_UNICODE_NEON )
+#if defined( _APG_UNICODE_SSE2 )
+static int _popcount64( uint64_t x ) {
+#if defined( __GNUC__ ) || defined( __clang__ )
+  return __builtin_popcountll( x );
+#else // MSVC's __popcnt64() needs a CPU with the POPCNT instruction, which SSE2 doesn't imply
+  x = x - ( ( x >> 1 ) & 0x5555555555555555ULL );
+  x = ( x & 0x3333333333333333ULL ) + ( ( x >> 2 ) & 0x3333333333333333ULL );
+  x = ( x + ( x >> 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+  return (int)( ( x * 0x0101010101010101ULL ) >> 56 );
+#endif
+}
+#endif
+
+// RETURNS the number of the 64 bytes at s that aren't continuation bytes 10xxxxxx. i.e. the number of codepoints that start in those bytes.
+static int _count_leads_64( const uint8_t* s ) {
+#if defined( _APG_UNICODE_AVX2 )
+  // as signed bytes, continuation bytes are -128 to -65 (0x80 to 0xBF), and are the only bytes less than -64 (0xC0)
+  const __m256i lead_min = _mm256_set1_epi8( -64 );
+  uint32_t conts_lo      = (uint32_t)_mm256_movemask_epi8( _mm256_cmpgt_epi8( lead_min, _mm256_loadu_si256( (const __m256i*)s ) ) );
+  uint32_t conts_hi      = (uint32_t)_mm256_movemask_epi8( _mm256_cmpgt_epi8( lead_min, _mm256_loadu_si256( (const __m256i*)&s[32] ) ) );
+  return 64 - _popcount64( ( (uint64_t)conts_hi << 32 ) | conts_lo );
+#elif defined( _APG_UNICODE_SSE2 )
+  const __m128i lead_min = _mm_set1_epi8( -64 );
+  uint64_t conts         = 0;
+  for ( int i = 0; i < 4; i++ ) {
+    conts |= (uint64_t)(uint32_t)_mm_movemask_epi8( _mm_cmplt_epi8( _mm_loadu_si128( (const __m128i*)&s[i * 16] ), lead_min ) ) << ( i * 16 );
+  }
+  return 64 - _popcount64( conts );
+#else
+  // NEON has no movemask, so each continuation byte is made a 1 and the lanes are summed. each lane can reach at most 4.
+  const uint8x16_t top_two_mask = vdupq_n_u8( MASK_FIRST_TWO ), cont_bits = vdupq_n_u8( MASK_FIRST_ONE );
+  uint8x16_t conts              = vdupq_n_u8( 0 );
+  for ( int i = 0; i < 4; i++ ) { conts = vaddq_u8( conts, vshrq_n_u8( vceqq_u8( vandq_u8( vld1q_u8( &s[i * 16] ), top_two_mask ), cont_bits ), 7 ) ); }
+  uint64x2_t sums = vpaddlq_u32( vpaddlq_u16( vpaddlq_u8( conts ) ) );
+  return 64 - (int)( vgetq_lane_u64( sums, 0 ) + vgetq_lane_u64( sums, 1 ) );
+#endif
+}
+#endif
+
+size_t apg_utf8_count_cp_len( const char* buf, size_t len ) {
+  assert( buf || 0 == len );
+  if ( !buf ) { return 0; }
+  const uint8_t* s = (const uint8_t*)buf;
+
+  // every codepoint has exactly one byte that isn't a continuation byte 10xxxxxx, so there's no need to decode
+  size_t ncode_points = 0, i = 0;
+#if defined( _APG_UNICODE_SSE2 ) || defined( _APG_UNICODE_NEON )
+  for ( ; i + 64 <= len; i += 64 ) { ncode_points += _count_leads_64( &s[i] ); }
+#endif
+  for ( ; i < len; i++ ) { ncode_points += ( s[i] & MASK_FIRST_TWO ) != MASK_FIRST_ONE; }
+  return ncode_points;
+}
+
+size_t apg_utf8_offset_of_cp( const char* buf, size_t len, size_t n ) {
+  assert( buf || 0 == len );
+  if ( !buf ) { return 0; }
+  const uint8_t* s = (const uint8_t*)buf;
+
+  size_t i = 0;
+#if defined( _APG_UNICODE_SSE2 ) || defined( _APG_UNICODE_NEON )
+  // skip whole blocks that end before the n-th codepoint starts
+  for ( ; i + 64 <= len; i += 64 ) {
+    size_t n_leads = (size_t)_count_leads_64( &s[i] );
+    if ( n_leads > n ) { break; }
+    n -= n_leads;
+  }
+#endif
+  for ( ; i < len; i++ ) {
+    if ( ( s[i] & MASK_FIRST_TWO ) == MASK_FIRST_ONE ) { continue; }
+    if ( 0 == n ) { return i; }
+    n--;
+  }
+  return len;
+}
+
 int apg_utf8_count_cp( const char* buf ) {
   assert( buf );
   if ( !buf ) { return -1; }
 
-  int ncode_points = 0;
-  int current_byte = 0;
-  int sz           = strnlen( buf, APG_UNICODE_MAX_STR );
-  int nbytes       = 0;
-  for ( int i = 0; i < sz; i += nbytes ) {
-    uint32_t code = apg_utf8_to_cp( &buf[current_byte], &nbytes );
-    current_byte += nbytes;
-    ncode_points++;
+  size_t ncode_points = apg_utf8_count_cp_len( buf, strlen( buf ) );
+  return ncode_points > INT_MAX ? INT_MAX : (int)ncode_points;
+}
+
+void apg_utf8_reverse_len( char* out, const char* in, size_t len ) {
+  assert( ( out && in ) || 0 == len );
+  if ( !out || !in ) { return; }
+
+  // reverse all of the bytes, then put the bytes of each multi-byte sequence back in order. a reversed sequence is its continuation bytes then its lead byte.
+  if ( out != in ) { memmove( out, in, len ); }
+  for ( size_t i = 0, j = len; i + 1 < j; i++, j-- ) {
+    char tmp   = out[i];
+    out[i]     = out[j - 1];
+    out[j - 1] = tmp;
+  }
+  for ( size_t i = 0; i < len; i++ ) {
+    size_t lead_idx = i;
+    while ( lead_idx < len && lead_idx - i < 3 && ( (uint8_t)out[lead_idx] & MASK_FIRST_TWO ) == MASK_FIRST_ONE ) { lead_idx++; }
+    if ( lead_idx == i || lead_idx >= len || ( (uint8_t)out[lead_idx] & MASK_FIRST_TWO ) != MASK_FIRST_TWO ) { continue; } // ASCII, or not a sequence
+    for ( size_t a = i, b = lead_idx; a < b; a++, b-- ) {
+      char tmp = out[a];
+      out[a]   = out[b];
+      out[b]   = tmp;
+    }
+    i = lead_idx;
   }
-  return ncode_points;
 }
 
 void apg_utf8_reverse( char* out, const char* in ) {
   assert( out && in );
   if ( !out || !in ) { return; }
 
-  int sz        = strnlen( in, APG_UNICODE_MAX_STR );
-  char* tmp_ptr = malloc( sz + 1 );
-  tmp_ptr[sz]   = 0;
-
-  int byte_idx = 0;
-  while ( byte_idx < sz ) {
-    int nbytes  = 0;
-    uint32_t cp = apg_utf8_to_cp( &in[byte_idx], &nbytes );
-    int out_idx = sz - byte_idx - nbytes;
-    memcpy( &tmp_ptr[out_idx], &in[byte_idx], nbytes );
-    byte_idx += nbytes;
-  }
-  out[0] = 0;
-  strncat( out, tmp_ptr, sz );
-  free( tmp_ptr );
+  size_t len = strlen( in );
+  apg_utf8_reverse_len( out, in, len );
+  out[len] = '\0';
 }
 
 // they all have general unicode, isolated form, end form. only some have middle and beginning form
@@ -208,10 +720,7 @@ void apg_utf8_reverse( char* out, const char* in ) {
 static uint32_t arabic_cp_end_cursive[256];    // subtract 0x0600 from codepoint to get its index into this
 static uint32_t arabic_cp_middle_cursive[256]; // subtract 0x0600 from codepoint to get its index into this
 uint32_t apg_cursive_arabic_cp( uint32_t cp_left, uint32_t cp, uint32_t cp_right ) {
-  if ( cp < 0x0600 || cp > 0x06FF ) {
-    fprintf( stderr, "  - using original cp - NOT ARABIC CURSIVE FORM CP\n" );
-    return cp;
-  }
+  if ( cp < 0x0600 || cp > 0x06FF ) { return cp; } // not Arabic
   static bool already_set_up = false;
 
   if ( !already_set_up ) {
@@ -319,73 +828,79 @@ uint32_t apg_cursive_arabic_cp( uint32_t cp_left, uint32_t cp, uint32_t cp_right
   return cp; // no cigar!
 }
 
-// TODO(Anton) if out is NULL then it should still run but just reporting out_sz required
-void apg_utf8_convert_to_arabic_cursive( char* out, const char* in, int* out_sz ) {
-  assert( in && out && out_sz );
-  if ( !out || !in || !out_sz ) { return; }
-
-  int in_sz        = strnlen( in, APG_UNICODE_MAX_STR );
-  int in_byte_idx  = 0;
-  *out_sz          = 0;
-  uint32_t prev_cp = 0;
-  out[0]           = '\0';
-  for ( int i = 0; in_byte_idx < in_sz && i < APG_UNICODE_MAX_STR; i++ ) {
-    int nbytes          = 0;
-    uint32_t right_cp   = prev_cp;
-    uint32_t code_point = apg_utf8_to_cp( &in[in_byte_idx], &nbytes );
+size_t apg_utf8_convert_to_arabic_cursive_len( char* out, const char* in, size_t len ) {
+  assert( in || 0 == len );
+  if ( !in ) { return 0; }
 
+  const uint8_t* s    = (const uint8_t*)in;
+  uint8_t* dst        = (uint8_t*)out;
+  size_t in_byte_idx  = 0;
+  size_t out_sz       = 0;
+  uint32_t right_cp   = 0;
+  uint32_t code_point = 0;
+  int nbytes          = len > 0 ? _decode_seq( s, len, &code_point ) : 0;
+  // each codepoint is decoded once, as the left neighbour of the previous one, and its cursive form is written straight to the end of the output
+  while ( nbytes > 0 ) {
     uint32_t left_cp  = 0;
     int nbytes_leftcp = 0;
-    // TODO(Anton) can re-arrange to just do 1 decoding per iteration
-    if ( in_byte_idx + nbytes < in_sz ) { left_cp = apg_utf8_to_cp( &in[in_byte_idx + nbytes], &nbytes_leftcp ); }
+    if ( in_byte_idx + nbytes < len ) { nbytes_leftcp = _decode_seq( &s[in_byte_idx + nbytes], len - in_byte_idx - nbytes, &left_cp ); }
 
-    char tmp[5];
-    tmp[0] = 0;
-    strncat( tmp, &in[in_byte_idx], nbytes );
-    tmp[0] = 0;
-    strncat( tmp, &in[in_byte_idx + nbytes], nbytes_leftcp );
+    uint8_t mbs[4];
+    int nbytes_c = _encode_cp( apg_cursive_arabic_cp( left_cp, code_point, right_cp ), mbs );
+    if ( dst ) { memcpy( &dst[out_sz], mbs, nbytes_c ); }
+    out_sz += nbytes_c;
 
-    uint32_t cursive_cp = apg_cursive_arabic_cp( left_cp, code_point, right_cp );
-    { // copy mbs into output string
-      char mbs[5];
-      int nbytes_c = apg_cp_to_utf8( cursive_cp, mbs );
-      strncat( out, mbs, nbytes_c );
-    }
-    prev_cp = code_point;
+    right_cp   = code_point;
+    code_point = left_cp;
     in_byte_idx += nbytes;
+    nbytes = nbytes_leftcp;
+  }
+  return out_sz;
+}
+
+void apg_utf8_convert_to_arabic_cursive( char* out, const char* in, int* out_sz ) {
+  assert( in && out_sz );
+  if ( !in || !out_sz ) { return; }
+
+  size_t sz = apg_utf8_convert_to_arabic_cursive_len( out, in, strlen( in ) );
+  if ( out ) { out[sz] = '\0'; }
+  *out_sz = sz > INT_MAX ? INT_MAX : (int)sz;
+}
+
+size_t apg_utf8_trim_end_len( const char* buf, size_t len, size_t n ) {
+  assert( buf || 0 == len );
+  if ( !buf ) { return 0; }
+
+  // walk back from the end over n codepoints. each one ends where a lead byte, or ASCII, is found within the last 4 bytes.
+  for ( ; n > 0 && len > 0; n-- ) {
+    len--;
+    for ( int i = 0; i < 3 && len > 0 && ( (uint8_t)buf[len] & MASK_FIRST_TWO ) == MASK_FIRST_ONE; i++ ) { len--; }
   }
-  *out_sz = strnlen( out, APG_UNICODE_MAX_STR );
+  return len;
 }
 
 void apg_utf8_trim_end( char* buf, int n ) {
   if ( n <= 0 ) { return; }
   assert( buf );
 
-  int ncode_points = apg_utf8_count_cp( buf );
-  // trim all remaining chars
-  if ( ncode_points <= n ) {
-    buf[0] = '\0';
-    return;
-  }
+  buf[apg_utf8_trim_end_len( buf, strlen( buf ), (size_t)n )] = '\0';
+}
 
-  int current_byte       = 0;
-  int sz                 = strnlen( buf, APG_UNICODE_MAX_STR );
-  int current_code_point = 0;
-  for ( int i = 0; current_byte < sz && i < APG_UNICODE_MAX_STR; i++ ) {
-    int nbytes    = 0;
-    uint32_t code = apg_utf8_to_cp( &buf[current_byte], &nbytes );
-    current_byte += nbytes;
-    current_code_point++;
-    if ( current_code_point >= ncode_points - n ) {
-      buf[current_byte] = '\0';
-      return;
-    }
+#ifdef APG_UNICODE_TESTS
+// RETURNS the position of the first invalid sequence in buf, or len, decoding one sequence at a time. for checking the SIMD paths of apg_utf8_validate().
+static size_t _test_validate_scalar( const char* buf, size_t len ) {
+  for ( size_t i = 0; i < len; ) {
+    uint32_t cp = 0;
+    int nbytes  = _decode_seq( (const uint8_t*)&buf[i], len - i, &cp );
+    if ( 0 == nbytes ) { return i; }
+    i += nbytes;
   }
+  return len;
 }
 
-#ifdef APG_UNICODE_TESTS
 // unit tests for input and output of utf-8 encoding
 int main() {
+  int n_errors = 0;
   FILE* fp = fopen( "out.txt", "w" );
   const char* test_string =
     "Fáilte.Ő ΏΘ ЩӜ ݞ  ణ ആ ญ ᚉ ant😈n ᛋ € ✋ is Amazing ✌️ ぢぽ\n习乡乢乣乤乥书乧乨乩乪乫乬乭乮乯𠀀 ";
@@ -397,7 +912,7 @@ int main() {
   fprintf( fp, "[%s]\n", string_b );
   fprintf( fp, "[%s]\n", test_string );
   char* ptr = (char*)test_string;
-  int sz    = strnlen( test_string, APG_UNICODE_MAX_STR );
+  int sz    = (int)strlen( test_string );
   while ( sz > 0 ) {
     uint32_t cp = apg_utf8_to_cp( ptr, &sz );
 
@@ -407,12 +922,227 @@ int main() {
 
     char tmpb[5];
     int szb = apg_cp_to_utf8( cp, tmpb );
-    if ( 0 != strcmp( tmp, tmpb ) ) { fprintf( fp, "ERROR [%s] vs [%s] cp = %u (U+%04X), sz = %i,%i\n", tmp, tmpb, cp, cp, sz, szb ); }
+    if ( 0 != strcmp( tmp, tmpb ) ) {
+      fprintf( fp, "ERROR [%s] vs [%s] cp = %u (U+%04X), sz = %i,%i\n", tmp, tmpb, cp, cp, sz, szb );
+      n_errors++;
+    }
 
     fprintf( fp, "[%s] cp = %u (U+%04X), sz = %i\n", tmp, cp, cp, sz );
     ptr += sz;
   }
   fclose( fp );
-  return 0;
+
+  { // bulk decoding matches decoding one codepoint at a time, including 4-byte sequences above U+3FFFF
+    const char* str = "ant\xF0\x9F\x98\x88n \xE2\x82\xAC \xF4\x8F\xBF\xBF \xF1\x80\x80\x80 The quick brown fox jumps over the lazy dog.";
+    size_t len      = strlen( str ), error_pos = 0;
+    uint32_t cps[128];
+    size_t n_cps = apg_utf8_decode( str, len, cps, &error_pos );
+    int byte_idx = 0;
+    for ( size_t i = 0; i < n_cps; i++ ) {
+      int nbytes  = 0;
+      uint32_t cp = apg_utf8_to_cp( &str[byte_idx], &nbytes );
+      if ( cp != cps[i] ) {
+        fprintf( stderr, "ERROR: decoded codepoint %u is U+%04X, expected U+%04X\n", (unsigned)i, cps[i], cp );
+        n_errors++;
+      }
+      byte_idx += nbytes;
+    }
+    if ( error_pos != len || (size_t)byte_idx != len || apg_utf8_validate( str, len ) != len || cps[3] != 0x1F608 || cps[8] != 0x10FFFF || cps[10] != 0x40000 ) {
+      fprintf( stderr, "ERROR: decoding valid string. error_pos=%u byte_idx=%i\n", (unsigned)error_pos, byte_idx );
+      n_errors++;
+    }
+  }
+
+  { // invalid sequences are reported at the byte they start, in short strings and past the first 16 and 32-byte blocks
+    const char* invalid[] = {
+      "\xC0\x80",         // overlong 2-byte
+      "\xE0\x9F\xBF",     // overlong 3-byte
+      "\xF0\x8F\xBF\xBF", // overlong 4-byte
+      "\xED\xA0\x80",     // surrogate
+      "\xF4\x90\x80\x80", // above U+10FFFF
+      "\xF8\x88\x80\x80", // 5-byte lead
+      "\x80",             // continuation without a lead
+      "\xE2\x82",         // cut off by the end of the string
+      "\xE2\x82x"         // cut off by ASCII
+    };
+    for ( int i = 0; i < (int)( sizeof( invalid ) / sizeof( invalid[0] ) ); i++ ) {
+      for ( size_t prefix_len = 0; prefix_len < 40; prefix_len += 13 ) {
+        char buf[64];
+        uint32_t cps[64];
+        memset( buf, 'a', prefix_len );
+        size_t len = prefix_len + strlen( invalid[i] ), error_pos = 0;
+        memcpy( &buf[prefix_len], invalid[i], strlen( invalid[i] ) );
+        size_t n_cps = apg_utf8_decode( buf, len, cps, &error_pos );
+        if ( apg_utf8_validate( buf, len ) != prefix_len || error_pos != prefix_len || n_cps != prefix_len ) {
+          fprintf( stderr, "ERROR: invalid sequence %i after %u bytes not found\n", i, (unsigned)prefix_len );
+          n_errors++;
+        }
+      }
+    }
+  }
+
+  { // random mixes of ASCII, multi-byte sequences, and corrupted bytes agree with the scalar validator
+    const char* pieces[] = { "a", "The quick brown fox ", "\xC3\xA1", "\xE2\x82\xAC", "\xF0\x9F\x98\x88", "\xEF\xBF\xBD", "\xF4\x8F\xBF\xBF" };
+    srand( 1 );
+    for ( int test = 0; test < 20000; test++ ) {
+      char buf[256];
+      size_t len = 0;
+      while ( len < 200 ) {
+        const char* piece = pieces[rand() % 7];
+        memcpy( &buf[len], piece, strlen( piece ) );
+        len += strlen( piece );
+      }
+      len -= (size_t)( rand() % 40 );                                                    // may cut a sequence off
+      if ( test % 2 ) { buf[rand() % len] = (char)( rand() % 256 ); }                    // may corrupt a sequence
+      if ( test % 3 ) { buf[rand() % len] = (char)( 0x80 | ( rand() % 64 ) ); }         // may add a stray continuation byte
+      size_t expected = _test_validate_scalar( buf, len ), error_pos = 0;
+      uint32_t cps[256];
+      apg_utf8_decode( buf, len, cps, &error_pos );
+      size_t result = apg_utf8_validate( buf, len );
+      if ( result != expected || error_pos != expected ) {
+        fprintf( stderr, "ERROR: test %i validate=%u decode=%u expected=%u\n", test, (unsigned)result, (unsigned)error_pos, (unsigned)expected );
+        n_errors++;
+      }
+
+      // the valid part round-trips through UTF-32 and UTF-16
+      char round_trip[256];
+      uint16_t units[256];
+      size_t n_cps   = apg_utf8_decode( buf, expected, cps, NULL );
+      size_t n_units = apg_utf8_to_utf16( buf, expected, units, 256, NULL, NULL ), n_written = 0;
+      if ( apg_utf32_to_utf8( cps, n_cps, NULL, 0, NULL ) != expected || apg_utf32_to_utf8( cps, n_cps, round_trip, 256, &n_written ) != expected ||
+           n_written != expected || 0 != memcmp( round_trip, buf, expected ) || apg_utf16_to_utf8( units, n_units, round_trip, 256, NULL, &error_pos ) != expected ||
+           error_pos != n_units || 0 != memcmp( round_trip, buf, expected ) || apg_utf8_to_utf16( buf, expected, NULL, 0, NULL, NULL ) != n_units ) {
+        fprintf( stderr, "ERROR: test %i round trip of %u bytes\n", test, (unsigned)expected );
+        n_errors++;
+      }
+
+      // counting codepoints, and finding each one, agrees with a byte at a time
+      size_t n_leads = 0;
+      for ( size_t i = 0; i < len; i++ ) {
+        if ( ( (uint8_t)buf[i] & MASK_FIRST_TWO ) == MASK_FIRST_ONE ) { continue; }
+        if ( apg_utf8_offset_of_cp( buf, len, n_leads ) != i ) {
+          fprintf( stderr, "ERROR: test %i offset of codepoint %u\n", test, (unsigned)n_leads );
+          n_errors++;
+        }
+        n_leads++;
+      }
+      if ( apg_utf8_count_cp_len( buf, len ) != n_leads || apg_utf8_offset_of_cp( buf, len, n_leads ) != len ) {
+        fprintf( stderr, "ERROR: test %i counting %u codepoints\n", test, (unsigned)n_leads );
+        n_errors++;
+      }
+    }
+  }
+
+  { // encoding into small buffers, invalid codepoints, and surrogate pairs
+    const uint32_t cps[] = { 'a', 'n', 't', 0x1F608, 'n', 0xD800, 0x110000 };
+    char out[16];
+    memset( out, '#', sizeof( out ) );
+    size_t n_written = 0;
+    size_t n_bytes   = apg_utf32_to_utf8( cps, 5, out, 5, &n_written ); // the emoji doesn't fit
+    if ( n_bytes != 8 || n_written != 3 || 0 != memcmp( out, "ant#", 4 ) ) {
+      fprintf( stderr, "ERROR: encoding into a small buffer. n_bytes=%u\n", (unsigned)n_bytes );
+      n_errors++;
+    }
+    n_bytes = apg_utf32_to_utf8( &cps[5], 2, out, sizeof( out ), NULL );
+    if ( n_bytes != 6 || 0 != memcmp( out, "\xEF\xBF\xBD\xEF\xBF\xBD", 6 ) ) {
+      fprintf( stderr, "ERROR: encoding invalid codepoints. n_bytes=%u\n", (unsigned)n_bytes );
+      n_errors++;
+    }
+    uint16_t units[4] = { 0 }, unpaired[] = { 'a', 0xDC00, 'b' };
+    size_t n_units = apg_utf8_to_utf16( "a\xF0\x9F\x98\x88", 5, units, 4, NULL, NULL ), error_pos = 0;
+    n_bytes        = apg_utf16_to_utf8( unpaired, 3, out, sizeof( out ), NULL, &error_pos );
+    if ( n_units != 3 || units[1] != 0xD83D || units[2] != 0xDE08 || n_bytes != 1 || error_pos != 1 ) {
+      fprintf( stderr, "ERROR: UTF-16 surrogates. n_units=%u n_bytes=%u error_pos=%u\n", (unsigned)n_units, (unsigned)n_bytes, (unsigned)error_pos );
+      n_errors++;
+    }
+  }
+
+  { // output buffers of every size up to the whole encoding, including sizes that cut through ASCII runs longer than 16, hold the whole sequences that fit
+    const char* str = "The quick brown fox jumps over the lazy dog \xE2\x82\xAC\xF0\x9F\x98\x88 and then some more ASCII text, to the end.";
+    size_t len = strlen( str ), n_cps = 0, n_units = 0;
+    uint32_t cps[128];
+    uint16_t units[128], units_out[128];
+    char out[128];
+    n_cps   = apg_utf8_decode( str, len, cps, NULL );
+    n_units = apg_utf8_to_utf16( str, len, units, 128, NULL, NULL );
+    for ( size_t out_sz = 0; out_sz <= len; out_sz++ ) {
+      size_t expected = out_sz; // the longest run of whole sequences that fits
+      while ( expected > 0 && expected < len && ( (uint8_t)str[expected] & MASK_FIRST_TWO ) == MASK_FIRST_ONE ) { expected--; }
+      size_t n_written_32 = 0, n_written_16 = 0;
+      memset( out, '#', sizeof( out ) );
+      size_t n_bytes_32 = apg_utf32_to_utf8( cps, n_cps, out, out_sz, &n_written_32 );
+      bool ok_32        = n_bytes_32 == len && n_written_32 == expected && 0 == memcmp( out, str, expected ) && '#' == out[expected];
+      memset( out, '#', sizeof( out ) );
+      size_t n_bytes_16 = apg_utf16_to_utf8( units, n_units, out, out_sz, &n_written_16, NULL );
+      bool ok_16        = n_bytes_16 == len && n_written_16 == expected && 0 == memcmp( out, str, expected ) && '#' == out[expected];
+      if ( !ok_32 || !ok_16 ) {
+        fprintf( stderr, "ERROR: encoding UTF-8 into %u bytes. wrote %u and %u\n", (unsigned)out_sz, (unsigned)n_written_32, (unsigned)n_written_16 );
+        n_errors++;
+      }
+    }
+    for ( size_t out_units = 0; out_units <= n_units; out_units++ ) {
+      size_t expected = out_units;
+      if ( expected > 0 && expected < n_units && units[expected] >= 0xDC00 && units[expected] <= 0xDFFF ) { expected--; } // don't split a surrogate pair
+      size_t n_written = 0;
+      memset( units_out, 0xFF, sizeof( units_out ) );
+      size_t n_units_out = apg_utf8_to_utf16( str, len, units_out, out_units, &n_written, NULL );
+      if ( n_units_out != n_units || n_written != expected || 0 != memcmp( units_out, units, expected * sizeof( uint16_t ) ) || 0xFFFF != units_out[expected] ) {
+        fprintf( stderr, "ERROR: encoding UTF-16 into %u units. wrote %u\n", (unsigned)out_units, (unsigned)n_written );
+        n_errors++;
+      }
+    }
+  }
+
+  { // Arabic cursive forms, and the output size without an output buffer
+    const char* arabic = "\xD9\x85\xD8\xB1\xD8\xAD\xD8\xA8\xD8\xA7 abc"; // U+0645 U+0631 U+062D U+0628 U+0627
+    char out[64];
+    int out_sz = 0, out_sz_required = 0;
+    apg_utf8_convert_to_arabic_cursive( NULL, arabic, &out_sz_required );
+    apg_utf8_convert_to_arabic_cursive( out, arabic, &out_sz );
+    if ( out_sz != out_sz_required || out_sz != (int)strlen( out ) || 0 != memcmp( &out[out_sz - 4], " abc", 4 ) || apg_utf8_count_cp( out ) != 9 ) {
+      fprintf( stderr, "ERROR: Arabic cursive conversion. out_sz=%i required=%i\n", out_sz, out_sz_required );
+      n_errors++;
+    }
+    // the same, from a slice of a string that isn't nul-terminated after the Arabic
+    size_t slice_sz = apg_utf8_convert_to_arabic_cursive_len( out, arabic, 10 );
+    if ( slice_sz != (size_t)out_sz - 4 || apg_utf8_convert_to_arabic_cursive_len( NULL, arabic, 10 ) != slice_sz ) {
+      fprintf( stderr, "ERROR: Arabic cursive conversion of a slice. out_sz=%u\n", (unsigned)slice_sz );
+      n_errors++;
+    }
+  }
+
+  { // strings longer than the old 2048-byte limit, reversed in-place, and trimmed from the end
+    size_t len = 10000;
+    char* big  = malloc( len + 1 );
+    char* copy = malloc( len + 1 );
+    uint32_t* cps_fwd = malloc( len * sizeof( uint32_t ) );
+    uint32_t* cps_rev = malloc( len * sizeof( uint32_t ) );
+    if ( !big || !copy || !cps_fwd || !cps_rev ) { return 1; }
+    for ( size_t i = 0; i < len; i += 8 ) { memcpy( &big[i], "a\xE2\x82\xAC\xF0\x9F\x98\x88", 8 ); } // a € 😈
+    big[len] = '\0';
+    memcpy( copy, big, len + 1 );
+    size_t n_cps = apg_utf8_decode( big, len, cps_fwd, NULL );
+    apg_utf8_reverse( big, big );
+    size_t n_rev = apg_utf8_decode( big, len, cps_rev, NULL );
+    bool reversed = n_cps == n_rev && apg_utf8_count_cp( big ) == 3750 && strlen( big ) == len;
+    for ( size_t i = 0; reversed && i < n_cps; i++ ) { reversed = cps_fwd[i] == cps_rev[n_cps - 1 - i]; }
+    apg_utf8_reverse_len( big, big, len );
+    if ( !reversed || 0 != memcmp( big, copy, len + 1 ) ) {
+      fprintf( stderr, "ERROR: reversing a long string\n" );
+      n_errors++;
+    }
+    apg_utf8_trim_end( big, 3749 );
+    if ( 0 != strcmp( big, "a" ) || apg_utf8_trim_end_len( copy, len, 2 ) != len - 7 || apg_utf8_trim_end_len( copy, len, 9999 ) != 0 ) {
+      fprintf( stderr, "ERROR: trimming a long string\n" );
+      n_errors++;
+    }
+    free( big );
+    free( copy );
+    free( cps_fwd );
+    free( cps_rev );
+  }
+
+  printf( "%i errors\n", n_errors );
+  return n_errors > 0 ? 1 : 0;
 }
 #endif
@@ -1,13 +1,11 @@
 /* apg_unicode
 Unicode <-> UTF-8 Multibyte String Functions for C & C++
 Anton Gerdelan
-Version: 0.2. 3 May 2020.
+Version: 0.6. 18 Oct 2026.
 Licence: see bottom of file.
 C89 ( Implementation is C99 )
 
 TODO:
-* Find out why some vars in bitwise ops are unused - feels like a copy-paste mistake between versions.
-* Compile with all warnings and address unused vars etc.
 * More tests. Arabic, reversed, etc
 * CI tests.
 
@@ -22,9 +20,17 @@ Further Reading:
 
 History:
 * 0.2. 3 May 2020 Dug up unicode files from Project Storm and brushed off the dust.
+* 0.3. 18 Oct 2026 apg_utf8_validate() and apg_utf8_decode() for whole buffers, with SIMD fast paths. Fixed decoding of 3 and 4-byte sequences.
+  apg_utf8_to_cp() no longer prints errors.
+* 0.4. 18 Oct 2026 apg_utf32_to_utf8(), apg_utf16_to_utf8() and apg_utf8_to_utf16() with a length-only mode. The Arabic converter writes straight to the
+  output rather than appending with strncat(), and accepts a NULL output to get the size required.
+* 0.5. 18 Oct 2026 _len() variants of functions taking nul-terminated strings, with no limit on string length. The old 2048-byte cap is gone.
+  apg_utf8_reverse() works in-place and without allocating. apg_utf8_trim_end() walks back from the end of the string.
+* 0.6. 18 Oct 2026 Codepoint counting 64 bytes at a time with AVX2, SSE2 or NEON. apg_utf8_offset_of_cp().
 */
 
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 
 /* Converts a unicode codepoint to an UTF-8 encoded multi-byte sequence.
@@ -43,19 +49,93 @@ RETURNS: Unicode codepoint, or 0 on error or end of string.
 */
 uint32_t apg_utf8_to_cp( const char* mbs, int* sz );
 
+/* Checks that a buffer is valid UTF-8. Overlong encodings, surrogates (U+D800 to U+DFFF), codepoints above U+10FFFF, and sequences cut off by the end of
+the buffer are all invalid.
+PARAMS
+buf - Bytes to check. Does not need to be nul-terminated. A 0 byte is valid ASCII.
+len - Number of bytes in buf.
+RETURNS: len if buf is valid, otherwise the byte offset of the start of the first invalid sequence.
+NOTE: Uses an SSSE3 validator where available, and otherwise skips over ASCII with SSE2 or NEON.
+*/
+size_t apg_utf8_validate( const char* buf, size_t len );
+
+/* Decodes a buffer of UTF-8 to unicode codepoints, stopping at the first invalid sequence (see apg_utf8_validate()).
+PARAMS
+buf       - Bytes to decode. Does not need to be nul-terminated.
+len       - Number of bytes in buf.
+out       - Output codepoints. Must have space for len codepoints, the most there can be (if every byte is ASCII).
+error_pos - Optional. Set to len if all of buf was decoded, otherwise the byte offset of the start of the first invalid sequence.
+RETURNS: Number of codepoints written to out.
+*/
+size_t apg_utf8_decode( const char* buf, size_t len, uint32_t* out, size_t* error_pos );
+
+/* Encodes unicode codepoints as UTF-8. Surrogates (U+D800 to U+DFFF) and codepoints above U+10FFFF are written as U+FFFD.
+PARAMS
+in     - Input codepoints.
+n_cps  - Number of codepoints in `in`.
+out       - Output buffer, or NULL to just get the length required. Not nul-terminated.
+out_sz    - Size of out in bytes.
+n_written - Optional. Set to the number of bytes written to out.
+RETURNS: Number of bytes in the whole encoding. If this is more than out_sz then out holds as many whole sequences as fit, from the start.
+*/
+size_t apg_utf32_to_utf8( const uint32_t* in, size_t n_cps, char* out, size_t out_sz, size_t* n_written );
+
+/* Transcodes UTF-16 to UTF-8, stopping at the first unpaired surrogate.
+PARAMS
+in        - Input UTF-16 code units, in native byte order.
+n_units   - Number of 16-bit code units in `in`.
+out       - Output buffer, or NULL to just get the length required. Not nul-terminated.
+out_sz    - Size of out in bytes.
+n_written - Optional. Set to the number of bytes written to out.
+error_pos - Optional. Set to n_units if all of the input was transcoded, otherwise the index of the unpaired surrogate.
+RETURNS: Number of bytes in the whole encoding. If this is more than out_sz then out holds as many whole sequences as fit, from the start.
+*/
+size_t apg_utf16_to_utf8( const uint16_t* in, size_t n_units, char* out, size_t out_sz, size_t* n_written, size_t* error_pos );
+
+/* Transcodes UTF-8 to UTF-16, stopping at the first invalid sequence (see apg_utf8_validate()).
+PARAMS
+in        - Input UTF-8. Does not need to be nul-terminated.
+len       - Number of bytes in `in`.
+out       - Output buffer of 16-bit code units in native byte order, or NULL to just get the length required. Not nul-terminated.
+out_units - Size of out in 16-bit code units.
+n_written - Optional. Set to the number of code units written to out.
+error_pos - Optional. Set to len if all of the input was transcoded, otherwise the byte offset of the start of the first invalid sequence.
+RETURNS: Number of code units in the whole encoding. If this is more than out_units then out holds as many whole codepoints as fit, from the start.
+*/
+size_t apg_utf8_to_utf16( const char* in, size_t len, uint16_t* out, size_t out_units, size_t* n_written, size_t* error_pos );
+
 /* Get number of codepoints in an UTF8-encoded sequence. Note that strlen() on a MBS returns the number of bytes, not codepoints.
 PARAMS
 buf - must be nul-terminated
-RETURNS < 0 on error, or the number of valid code points in the multi-byte sequence */
+RETURNS -1 if buf is NULL, otherwise the count from apg_utf8_count_cp_len(): the number of bytes that start a sequence, which is the number of codepoints if
+buf is valid UTF-8. Counts above INT_MAX are returned as INT_MAX - use apg_utf8_count_cp_len() for strings that long. */
 int apg_utf8_count_cp( const char* buf );
 
+/* As apg_utf8_count_cp(), but for len bytes of buf, which need not be nul-terminated.
+RETURNS the number of bytes in buf that start a sequence, which is the number of codepoints if buf is valid UTF-8. */
+size_t apg_utf8_count_cp_len( const char* buf, size_t len );
+
+/* Finds where a codepoint starts in a string, without decoding.
+PARAMS
+buf - UTF-8 string. Does not need to be nul-terminated.
+len - Number of bytes in buf.
+n   - Index of the codepoint to find. 0 is the first.
+RETURNS the byte offset of the n-th codepoint, or len if buf has n or fewer codepoints.
+NOTE: Like apg_utf8_count_cp_len() this counts bytes that aren't continuation bytes, which are the codepoints if buf is valid UTF-8.
+*/
+size_t apg_utf8_offset_of_cp( const char* buf, size_t len, size_t n );
+
 /* Reverse an UTF-8 encoded multi-byte string.
 PARAMS
-out - Output multi-byte string.
+out - Output multi-byte string. Can be the same as in.
 in  - Input multi-byte string. Must be nul-terminated.
 */
 void apg_utf8_reverse( char* out, const char* in );
 
+/* As apg_utf8_reverse(), but for len bytes of in, which need not be nul-terminated. out must have space for len bytes, and is not nul-terminated.
+out can be the same as in. */
+void apg_utf8_reverse_len( char* out, const char* in, size_t len );
+
 /* Conversion of Arabic codepoint to correct cursive form, based on cursive properties of neighbouring codepoints. Simply put: joins the lines together between
 characters.
 PARAMS: cp_left and cp_right are in order of writing/reading - right-to-left. So cp_right is the /earlier/ codepoint.
@@ -67,19 +147,30 @@ uint32_t apg_cursive_arabic_cp( uint32_t cp_left, uint32_t cp, uint32_t cp_right
 /* Converts any general Unicode Arabic characters (U+0627 to U+0649) to cursive-aware equivalents.
 PARAMS
 in  - Input must be in standard right-to-left memory arrangement. Must be nul-terminated.
-out - Output will be a string of the same size in range (U+FE70 to U+FEFF ).
+out - Output will be a string of the same size in range (U+FE70 to U+FEFF ). Can be NULL to just get out_sz.
+out_sz - Set to the length of the output string in bytes, not counting the nul terminator. Lengths above INT_MAX are set as INT_MAX - use
+         apg_utf8_convert_to_arabic_cursive_len() for strings that long.
 WARNING: You must allow extra space in the output buffer in case bytes required per codepoint increases to 3.
 */
 void apg_utf8_convert_to_arabic_cursive( char* out, const char* in, int* out_sz );
 
+/* As apg_utf8_convert_to_arabic_cursive(), but for len bytes of in, which need not be nul-terminated. Stops at the first invalid sequence in in.
+out is not nul-terminated, and can be NULL to just get the size required.
+RETURNS the number of bytes in the output.
+*/
+size_t apg_utf8_convert_to_arabic_cursive_len( char* out, const char* in, size_t len );
+
 /* Trims the end n chars from a utf8-encoded string.
 PARAMS
 buf - Must be nul-terminated.
-NOTE: Searches string from front-to-back so not efficient for long strings.
-Could instead be implemented to progressively look at last 4 bytes for unicode indicators.
 */
 void apg_utf8_trim_end( char* buf, int n );
 
+/* As apg_utf8_trim_end(), but for len bytes of buf, which need not be nul-terminated. buf is not modified.
+RETURNS the length in bytes of buf with the last n codepoints trimmed off, or 0 if buf has n or fewer codepoints.
+*/
+size_t apg_utf8_trim_end_len( const char* buf, size_t len, size_t n );
+
 /*
 -------------------------------------------------------------------------------------
 This software is available under two licences - you may use it under either licence.
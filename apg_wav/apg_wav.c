@@ -1,9 +1,29 @@
+#include "apg_wav.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#include <xmmintrin.h>
+#define APG_WAV_SSE
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define APG_WAV_NEON
+#endif
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define APG_WAV_SSE2
+#endif
+
+#define APG_WAV_RESAMPLE_BLOCK 1024  // frames buffered per channel inside a resampler, and per block when converting whole files
+#define APG_WAV_SINC_HALF_TAPS 16    // filter half-length in input samples when upsampling. grows when downsampling to keep the same transition band
+#define APG_WAV_SINC_MAX_HALF_TAPS 256
+#define APG_WAV_SINC_MAX_PHASES 512 // rate ratios needing more phases than this use the nearest phase
+#define APG_WAV_SINC_KAISER_BETA 8.0
+#define APG_WAV_SINC_ROLLOFF 0.95 // cutoff as a fraction of the lower Nyquist frequency
 
 struct wav_chunk_descr_t {
   char riff_str[4];  // "RIFF"
@@ -117,23 +137,631 @@ int apg_write_wav( const char* filename, const void* data, int n_chans, int samp
   return 1;
 }
 
+/* running totals for apg_wav_stats_t, accumulated block by block */
+struct wav_stats_accum_t {
+  int n_chans;
+  int bits_per_sample;
+  int64_t n_frames;
+  double sum[APG_WAV_STATS_MAX_CHANS];
+  double sum_sq[APG_WAV_STATS_MAX_CHANS];
+  int64_t peak[APG_WAV_STATS_MAX_CHANS];
+  int n_clipped[APG_WAV_STATS_MAX_CHANS];
+};
+
+static void _stats_accum_init( struct wav_stats_accum_t* acc, int n_chans, int bits_per_sample ) {
+  memset( acc, 0, sizeof( struct wav_stats_accum_t ) );
+  acc->n_chans         = n_chans < APG_WAV_STATS_MAX_CHANS ? n_chans : APG_WAV_STATS_MAX_CHANS;
+  acc->bits_per_sample = bits_per_sample;
+}
+
+// reads a signed sample value in the integer domain of the file's format. 8-bit wav is unsigned, wider formats are signed little-endian.
+static inline int32_t _pcm_sample( const uint8_t* src, int bits_per_sample, int idx ) {
+  switch ( bits_per_sample ) {
+  case 8: return (int32_t)src[idx] - 128;
+  case 16: return (int16_t)( src[2 * idx] | src[2 * idx + 1] << 8 );
+  case 24: return (int32_t)( (uint32_t)src[3 * idx] << 8 | (uint32_t)src[3 * idx + 1] << 16 | (uint32_t)src[3 * idx + 2] << 24 ) >> 8;
+  case 32: return (int32_t)( (uint32_t)src[4 * idx] | (uint32_t)src[4 * idx + 1] << 8 | (uint32_t)src[4 * idx + 2] << 16 | (uint32_t)src[4 * idx + 3] << 24 );
+  default: assert( false ); return 0;
+  }
+}
+
+// one strided pass per channel over a block of frames. the block is small enough to stay in cache between channels, and inlining with a constant
+// bits_per_sample removes the switch from the sample read. integer partial sums per block keep int->double conversions out of the loop for 8 and 16-bit.
+static inline void _stats_channels( struct wav_stats_accum_t* acc, const uint8_t* src, int n_chans, int n_frames, const int bits ) {
+  const int32_t lo = 8 == bits ? -128 : 16 == bits ? INT16_MIN : 24 == bits ? -8388608 : INT32_MIN;
+  const int32_t hi = 8 == bits ? 127 : 16 == bits ? INT16_MAX : 24 == bits ? 8388607 : INT32_MAX;
+  for ( int c = 0; c < acc->n_chans; c++ ) {
+    int64_t sum = 0, peak = acc->peak[c];
+    uint64_t isum_sq = 0;
+    double sum_sq    = 0.0;
+    int n_clipped    = 0;
+    for ( int i = 0; i < n_frames; i++ ) {
+      int32_t v = _pcm_sample( src, bits, i * n_chans + c );
+      int64_t a = v < 0 ? -(int64_t)v : v;
+      sum += v;
+      if ( bits <= 16 ) {
+        isum_sq += (uint32_t)( v * v ); // at most 2^30 per sample
+      } else {
+        sum_sq += (double)v * (double)v;
+      }
+      peak = a > peak ? a : peak;
+      n_clipped += ( v == lo ) | ( v == hi );
+    }
+    acc->sum[c] += (double)sum;
+    acc->sum_sq[c] += bits <= 16 ? (double)isum_sq : sum_sq;
+    acc->peak[c] = peak;
+    acc->n_clipped[c] += n_clipped;
+  }
+}
+
+#ifdef APG_WAV_SSE2
+// per-lane totals for 8 interleaved samples at a time. when n_chans divides 8, lane j always holds channel j % n_chans, so all channels share one pass.
+struct wav_stats_sse2_t {
+  __m128i v_min, v_max, n_clipped;                      // 8 x int16
+  __m128i sum_lo, sum_hi;                               // 4 x int32 - samples 0-3, 4-7
+  __m128i sq_even_lo, sq_even_hi, sq_odd_lo, sq_odd_hi; // 2 x uint64 - samples 0,2 / 4,6 / 1,3 / 5,7
+};
+
+#define APG_WAV_SSE2_MAX_STEPS 16384 // steps between folding lanes into the channel totals, before the int16 clip counts or int32 sums could overflow
+
+static inline void _stats_sse2_step( struct wav_stats_sse2_t* s, __m128i v, __m128i lo, __m128i hi ) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i even = _mm_set1_epi32( 0xFFFF );
+  s->v_min           = _mm_min_epi16( s->v_min, v );
+  s->v_max           = _mm_max_epi16( s->v_max, v );
+  s->n_clipped       = _mm_sub_epi16( s->n_clipped, _mm_or_si128( _mm_cmpeq_epi16( v, lo ), _mm_cmpeq_epi16( v, hi ) ) );
+  s->sum_lo          = _mm_add_epi32( s->sum_lo, _mm_srai_epi32( _mm_unpacklo_epi16( v, v ), 16 ) );
+  s->sum_hi          = _mm_add_epi32( s->sum_hi, _mm_srai_epi32( _mm_unpackhi_epi16( v, v ), 16 ) );
+  // squares of the even and odd samples kept apart, as neighbouring samples are different channels. each is at most 2^30.
+  __m128i sq_even = _mm_madd_epi16( v, _mm_and_si128( v, even ) );
+  __m128i sq_odd  = _mm_madd_epi16( v, _mm_andnot_si128( even, v ) );
+  s->sq_even_lo   = _mm_add_epi64( s->sq_even_lo, _mm_unpacklo_epi32( sq_even, zero ) );
+  s->sq_even_hi   = _mm_add_epi64( s->sq_even_hi, _mm_unpackhi_epi32( sq_even, zero ) );
+  s->sq_odd_lo    = _mm_add_epi64( s->sq_odd_lo, _mm_unpacklo_epi32( sq_odd, zero ) );
+  s->sq_odd_hi    = _mm_add_epi64( s->sq_odd_hi, _mm_unpackhi_epi32( sq_odd, zero ) );
+}
+
+// adds each lane's totals to its channel and resets the lanes
+static void _stats_sse2_fold( struct wav_stats_sse2_t* s, struct wav_stats_accum_t* acc, int n_chans ) {
+  int16_t v_min[8], v_max[8], n_clipped[8];
+  int32_t sum[8];
+  uint64_t sq_even[4], sq_odd[4];
+  _mm_storeu_si128( (__m128i*)v_min, s->v_min );
+  _mm_storeu_si128( (__m128i*)v_max, s->v_max );
+  _mm_storeu_si128( (__m128i*)n_clipped, s->n_clipped );
+  _mm_storeu_si128( (__m128i*)&sum[0], s->sum_lo );
+  _mm_storeu_si128( (__m128i*)&sum[4], s->sum_hi );
+  _mm_storeu_si128( (__m128i*)&sq_even[0], s->sq_even_lo );
+  _mm_storeu_si128( (__m128i*)&sq_even[2], s->sq_even_hi );
+  _mm_storeu_si128( (__m128i*)&sq_odd[0], s->sq_odd_lo );
+  _mm_storeu_si128( (__m128i*)&sq_odd[2], s->sq_odd_hi );
+  for ( int j = 0; j < 8; j++ ) {
+    int c        = j % n_chans;
+    int64_t peak = v_max[j] > -v_min[j] ? v_max[j] : -v_min[j];
+    acc->peak[c] = peak > acc->peak[c] ? peak : acc->peak[c];
+    acc->sum[c] += (double)sum[j];
+    acc->sum_sq[c] += (double)( j & 1 ? sq_odd[j / 2] : sq_even[j / 2] );
+    acc->n_clipped[c] += n_clipped[j];
+  }
+  memset( s, 0, sizeof( struct wav_stats_sse2_t ) );
+}
+
+// gathers 8 or 16-bit statistics for all channels in one pass, when n_chans divides 8. returns the number of frames done; the rest are left for the scalar path.
+static int _stats_sse2( struct wav_stats_accum_t* acc, const uint8_t* src, int n_chans, int n_frames ) {
+  const int bits         = acc->bits_per_sample;
+  const int step_samples = 8 == bits ? 16 : 8; // one 16-byte load is 16 8-bit or 8 16-bit samples
+  const int n_loads      = (int)( (int64_t)n_frames * n_chans / step_samples );
+  const __m128i lo       = _mm_set1_epi16( 8 == bits ? -128 : INT16_MIN );
+  const __m128i hi       = _mm_set1_epi16( 8 == bits ? 127 : INT16_MAX );
+  const __m128i bias     = _mm_set1_epi8( (char)0x80 );
+  struct wav_stats_sse2_t s;
+  memset( &s, 0, sizeof( struct wav_stats_sse2_t ) );
+  for ( int first = 0; first < n_loads; first += APG_WAV_SSE2_MAX_STEPS / 2 ) {
+    int last = n_loads - first < APG_WAV_SSE2_MAX_STEPS / 2 ? n_loads : first + APG_WAV_SSE2_MAX_STEPS / 2;
+    if ( 8 == bits ) {
+      for ( int i = first; i < last; i++ ) {
+        __m128i x = _mm_xor_si128( _mm_loadu_si128( (const __m128i*)&src[16 * i] ), bias ); // unsigned to signed
+        _stats_sse2_step( &s, _mm_srai_epi16( _mm_unpacklo_epi8( x, x ), 8 ), lo, hi );
+        _stats_sse2_step( &s, _mm_srai_epi16( _mm_unpackhi_epi8( x, x ), 8 ), lo, hi );
+      }
+    } else {
+      for ( int i = first; i < last; i++ ) { _stats_sse2_step( &s, _mm_loadu_si128( (const __m128i*)&src[16 * i] ), lo, hi ); }
+    }
+    _stats_sse2_fold( &s, acc, n_chans );
+  }
+  return (int)( (int64_t)n_loads * step_samples / n_chans );
+}
+#endif
+
+// gathers statistics for a block of frames while it is still in cache from being copied or converted.
+static void _stats_accum_block( struct wav_stats_accum_t* acc, const uint8_t* src, int n_chans, int n_frames ) {
+  const int bits = acc->bits_per_sample;
+  int n_done     = 0;
+#ifdef APG_WAV_SSE2
+  if ( ( 8 == bits || 16 == bits ) && 0 == 8 % n_chans ) { n_done = _stats_sse2( acc, src, n_chans, n_frames ); }
+#endif
+  const uint8_t* rest = &src[(size_t)n_done * n_chans * ( bits / 8 )];
+  switch ( bits ) {
+  case 8: _stats_channels( acc, rest, n_chans, n_frames - n_done, 8 ); break;
+  case 16: _stats_channels( acc, rest, n_chans, n_frames - n_done, 16 ); break;
+  case 24: _stats_channels( acc, rest, n_chans, n_frames - n_done, 24 ); break;
+  case 32: _stats_channels( acc, rest, n_chans, n_frames - n_done, 32 ); break;
+  default: assert( false ); break;
+  }
+  acc->n_frames += n_frames;
+}
+
+static void _stats_accum_finish( const struct wav_stats_accum_t* acc, apg_wav_stats_t* stats ) {
+  const double scale = 1.0 / (double)( (int64_t)1 << ( acc->bits_per_sample - 1 ) );
+  const double n     = acc->n_frames > 0 ? (double)acc->n_frames : 1.0;
+  memset( stats, 0, sizeof( apg_wav_stats_t ) );
+  stats->n_chans = acc->n_chans;
+  for ( int c = 0; c < acc->n_chans; c++ ) {
+    stats->peak[c]      = (float)( acc->peak[c] * scale );
+    stats->rms[c]       = (float)( sqrt( acc->sum_sq[c] / n ) * scale );
+    stats->dc[c]        = (float)( acc->sum[c] / n * scale );
+    stats->n_clipped[c] = acc->n_clipped[c];
+  }
+}
+
 unsigned char* apg_read_wav( const char* filename, int* n_chans, int* sample_rate, int* n_samples, int* bits_per_sample ) {
+  return apg_read_wav_with_stats( filename, n_chans, sample_rate, n_samples, bits_per_sample, NULL );
+}
+
+/* loads a whole file and finds its format and sample data. on success the caller must free() record->data. */
+static bool _load_wav_file( const char* filename, struct entire_file_t* record, const struct wav_fmt_subchunk_t** fmt, const uint8_t** samples, size_t* samples_sz ) {
+  record->data = NULL;
+  record->sz   = 0;
+  bool ret     = _read_entire_file( filename, record );
+  const size_t header_sz = sizeof( struct wav_chunk_descr_t ) + sizeof( struct wav_fmt_subchunk_t ) + sizeof( struct wav_data_subchunk_t );
+  if ( !ret || record->sz < header_sz ) {
+    free( record->data );
+    return false;
+  }
+  // TODO validate each subchunk
+  //struct wav_chunk_descr_t* chunk_descr   = (struct wav_chunk_descr_t*)record->data;
+  const struct wav_fmt_subchunk_t* fmt_subchunk = (struct wav_fmt_subchunk_t*)( (uint8_t*)record->data + sizeof( struct wav_chunk_descr_t ) );
+  const struct wav_data_subchunk_t* data_subchunk =
+    (struct wav_data_subchunk_t*)( (uint8_t*)record->data + sizeof( struct wav_fmt_subchunk_t ) + sizeof( struct wav_chunk_descr_t ) );
+  int bytes_per_frame = fmt_subchunk->n_chans * ( fmt_subchunk->bits_per_sample / 8 );
+  if ( bytes_per_frame <= 0 ) {
+    free( record->data );
+    return false;
+  }
+  size_t data_sz = data_subchunk->subchunk_2_sz;
+  if ( data_sz > record->sz - header_sz ) { data_sz = record->sz - header_sz; } // truncated file - return what there is
+  *fmt        = fmt_subchunk;
+  *samples    = (uint8_t*)record->data + header_sz;
+  *samples_sz = data_sz - data_sz % bytes_per_frame;
+  return true;
+}
+
+/* copies sample data into its own allocation, gathering stats, if not NULL, block by block during the copy */
+static unsigned char* _copy_samples( const uint8_t* src, size_t data_sz, int n_chans, int bits_per_sample, apg_wav_stats_t* stats ) {
+  unsigned char* wav_data = (unsigned char*)malloc( data_sz > 0 ? data_sz : 1 );
+  if ( !wav_data ) { return NULL; }
+  if ( stats && ( 8 == bits_per_sample || 16 == bits_per_sample || 24 == bits_per_sample || 32 == bits_per_sample ) ) {
+    const int bytes_per_frame = n_chans * ( bits_per_sample / 8 );
+    const size_t block_sz     = (size_t)APG_WAV_RESAMPLE_BLOCK * bytes_per_frame;
+    struct wav_stats_accum_t acc;
+    _stats_accum_init( &acc, n_chans, bits_per_sample );
+    for ( size_t offset = 0; offset < data_sz; offset += block_sz ) {
+      size_t sz = data_sz - offset < block_sz ? data_sz - offset : block_sz;
+      memcpy( &wav_data[offset], &src[offset], sz );
+      _stats_accum_block( &acc, &wav_data[offset], n_chans, (int)( sz / bytes_per_frame ) );
+    }
+    _stats_accum_finish( &acc, stats );
+  } else {
+    if ( stats ) { memset( stats, 0, sizeof( apg_wav_stats_t ) ); }
+    memcpy( wav_data, src, data_sz );
+  }
+  return wav_data;
+}
+
+unsigned char* apg_read_wav_with_stats( const char* filename, int* n_chans, int* sample_rate, int* n_samples, int* bits_per_sample, apg_wav_stats_t* stats ) {
   if ( !filename || !n_chans || !sample_rate || !n_samples || !bits_per_sample ) { return 0; }
   struct entire_file_t record;
-  bool ret = _read_entire_file( filename, &record );
-  if ( !ret || 0 == record.sz ) { return 0; }
-  // TODO validate each subchunk
-  //struct wav_chunk_descr_t* chunk_descr   = (struct wav_chunk_descr_t*)record.data;
-  struct wav_fmt_subchunk_t* fmt_subchunk = (struct wav_fmt_subchunk_t*)( (uint8_t*)record.data + sizeof( struct wav_chunk_descr_t ) );
-  //struct wav_data_subchunk_t* data_subchunk =
-   // (struct wav_data_subchunk_t*)( (uint8_t*)record.data + sizeof( struct wav_fmt_subchunk_t ) + sizeof( struct wav_chunk_descr_t ) );
-  unsigned char* wav_data =
-    (unsigned char*)( (uint8_t*)record.data + sizeof( struct wav_fmt_subchunk_t ) + sizeof( struct wav_chunk_descr_t ) + sizeof( struct wav_data_subchunk_t ) );
-  *n_chans         = fmt_subchunk->n_chans;
-  *sample_rate     = fmt_subchunk->sample_rate;
-  *bits_per_sample = fmt_subchunk->bits_per_sample;
-  // TODO derive *n_samples = fmt_subchunk->n_samples;
-
-  // TODO malloc the data separately
+  const struct wav_fmt_subchunk_t* fmt_subchunk = NULL;
+  const uint8_t* src                            = NULL;
+  size_t data_sz                                = 0;
+  if ( !_load_wav_file( filename, &record, &fmt_subchunk, &src, &data_sz ) ) { return 0; }
+
+  unsigned char* wav_data = _copy_samples( src, data_sz, fmt_subchunk->n_chans, fmt_subchunk->bits_per_sample, stats );
+  if ( wav_data ) {
+    *n_chans         = fmt_subchunk->n_chans;
+    *sample_rate     = fmt_subchunk->sample_rate;
+    *bits_per_sample = fmt_subchunk->bits_per_sample;
+    *n_samples       = (int)( data_sz / ( fmt_subchunk->n_chans * ( fmt_subchunk->bits_per_sample / 8 ) ) );
+  }
+  free( record.data );
+  return wav_data;
+}
+
+/* =======================================================================================================================
+sample rate conversion
+======================================================================================================================= */
+
+struct apg_wav_resampler_t {
+  int n_chans;
+  apg_wav_resample_quality_t quality;
+  uint32_t L, M;     // out_rate / in_rate reduced to lowest terms. each output frame advances M/L input frames.
+  int n_taps;        // input frames read per output frame
+  int n_taps_padded; // rounded up to a multiple of 4 for the SIMD dot product. padding coefficients are zero.
+  int n_phases;      // rows in the coefficient table, not counting the extra row for a phase of exactly 1.0
+  float* coeffs;     // ( n_phases + 1 ) * n_taps_padded
+  float* hist;       // planar input history. channel c starts at hist[c * hist_stride]
+  int hist_stride;   // hist_cap + padding so the dot product can read n_taps_padded frames from any valid window start
+  int hist_cap;      // frames of history held per channel
+  int hist_len;      // frames currently in history
+  int pos;           // history index of the first frame in the next output's filter window
+  uint32_t frac;     // fractional input position of the next output, in units of 1/L
+  int64_t n_in_total, n_out_total;
+  int flush_zeros; // zero frames still to append after the input ends, or -1 before flushing starts
+};
+
+static uint32_t _gcd( uint32_t a, uint32_t b ) {
+  while ( b ) {
+    uint32_t t = a % b;
+    a          = b;
+    b          = t;
+  }
+  return a;
+}
+
+// zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double _bessel_i0( double x ) {
+  double sum = 1.0, term = 1.0;
+  for ( int k = 1; k < 64; k++ ) {
+    term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+    sum += term;
+    if ( term < sum * 1e-12 ) { break; }
+  }
+  return sum;
+}
+
+static void _build_sinc_table( apg_wav_resampler_t* rs, double cutoff, int half ) {
+  const double pi      = 3.14159265358979323846;
+  const double i0_beta = _bessel_i0( APG_WAV_SINC_KAISER_BETA );
+  for ( int p = 0; p <= rs->n_phases; p++ ) {
+    float* row = &rs->coeffs[p * rs->n_taps_padded];
+    double t   = (double)p / (double)rs->n_phases;
+    double sum = 0.0;
+    for ( int k = 0; k < rs->n_taps; k++ ) {
+      double d    = t + ( half - 1 ) - k; // distance in input frames from the output position to this tap's sample
+      double sinc = d == 0.0 ? 1.0 : sin( pi * cutoff * d ) / ( pi * cutoff * d );
+      double r    = d / half;
+      double win  = r * r < 1.0 ? _bessel_i0( APG_WAV_SINC_KAISER_BETA * sqrt( 1.0 - r * r ) ) / i0_beta : 0.0;
+      double c    = cutoff * sinc * win;
+      row[k]      = (float)c;
+      sum += c;
+    }
+    for ( int k = 0; k < rs->n_taps; k++ ) { row[k] = (float)( row[k] / sum ); } // unity gain at DC for every phase
+  }
+}
+
+apg_wav_resampler_t* apg_wav_resampler_create( int n_chans, int in_rate, int out_rate, apg_wav_resample_quality_t quality ) {
+  if ( n_chans < 1 || in_rate <= 0 || out_rate <= 0 ) { return NULL; }
+  apg_wav_resampler_t* rs = (apg_wav_resampler_t*)calloc( 1, sizeof( apg_wav_resampler_t ) );
+  if ( !rs ) { return NULL; }
+
+  uint32_t g      = _gcd( (uint32_t)out_rate, (uint32_t)in_rate );
+  rs->n_chans     = n_chans;
+  rs->L           = (uint32_t)out_rate / g;
+  rs->M           = (uint32_t)in_rate / g;
+  rs->quality     = rs->L == rs->M ? APG_WAV_RESAMPLE_LINEAR : quality; // same rate - linear with a fixed phase of 0 is an exact copy
+  rs->flush_zeros = -1;
+
+  int half = 1;
+  switch ( rs->quality ) {
+  case APG_WAV_RESAMPLE_LINEAR: half = 1; break;
+  case APG_WAV_RESAMPLE_CUBIC: half = 2; break;
+  case APG_WAV_RESAMPLE_SINC: {
+    double ratio = rs->L < rs->M ? (double)rs->L / (double)rs->M : 1.0;
+    half         = (int)ceil( APG_WAV_SINC_HALF_TAPS / ratio );
+    if ( half > APG_WAV_SINC_MAX_HALF_TAPS ) { half = APG_WAV_SINC_MAX_HALF_TAPS; }
+  } break;
+  default: free( rs ); return NULL;
+  }
+  rs->n_taps        = 2 * half;
+  rs->n_taps_padded = ( rs->n_taps + 3 ) & ~3;
+  rs->hist_cap      = APG_WAV_RESAMPLE_BLOCK + rs->n_taps;
+  rs->hist_stride   = rs->hist_cap + rs->n_taps_padded;
+  rs->hist          = (float*)calloc( (size_t)rs->hist_stride * n_chans, sizeof( float ) );
+  if ( !rs->hist ) {
+    free( rs );
+    return NULL;
+  }
+  if ( APG_WAV_RESAMPLE_SINC == rs->quality ) {
+    rs->n_phases = rs->L <= APG_WAV_SINC_MAX_PHASES ? (int)rs->L : APG_WAV_SINC_MAX_PHASES;
+    rs->coeffs   = (float*)calloc( (size_t)( rs->n_phases + 1 ) * rs->n_taps_padded, sizeof( float ) );
+    if ( !rs->coeffs ) {
+      apg_wav_resampler_free( rs );
+      return NULL;
+    }
+    double cutoff = APG_WAV_SINC_ROLLOFF * ( rs->L < rs->M ? (double)rs->L / (double)rs->M : 1.0 );
+    _build_sinc_table( rs, cutoff, half );
+  }
+  // pre-pad with zeros so the first output's window, centred on input frame 0, starts at history index 0
+  rs->hist_len = half - 1;
+  return rs;
+}
+
+void apg_wav_resampler_free( apg_wav_resampler_t* rs ) {
+  if ( !rs ) { return; }
+  free( rs->coeffs );
+  free( rs->hist );
+  free( rs );
+}
+
+int apg_wav_resampler_max_out_frames( const apg_wav_resampler_t* rs, int n_in_frames ) {
+  if ( !rs || n_in_frames < 0 ) { return 0; }
+  return (int)( ( (int64_t)n_in_frames + rs->n_taps ) * rs->L / rs->M + 2 );
+}
+
+static float _dot( const float* a, const float* b, int n ) {
+#if defined( APG_WAV_SSE )
+  __m128 acc = _mm_setzero_ps();
+  for ( int i = 0; i < n; i += 4 ) { acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( &a[i] ), _mm_loadu_ps( &b[i] ) ) ); }
+  acc = _mm_add_ps( acc, _mm_movehl_ps( acc, acc ) );
+  acc = _mm_add_ss( acc, _mm_shuffle_ps( acc, acc, 1 ) );
+  return _mm_cvtss_f32( acc );
+#elif defined( APG_WAV_NEON )
+  float32x4_t acc = vdupq_n_f32( 0.0f );
+  for ( int i = 0; i < n; i += 4 ) { acc = vmlaq_f32( acc, vld1q_f32( &a[i] ), vld1q_f32( &b[i] ) ); }
+  float32x2_t sum = vadd_f32( vget_low_f32( acc ), vget_high_f32( acc ) );
+  return vget_lane_f32( vpadd_f32( sum, sum ), 0 );
+#else
+  float acc[4] = { 0.0f };
+  for ( int i = 0; i < n; i += 4 ) {
+    acc[0] += a[i] * b[i];
+    acc[1] += a[i + 1] * b[i + 1];
+    acc[2] += a[i + 2] * b[i + 2];
+    acc[3] += a[i + 3] * b[i + 3];
+  }
+  return ( acc[0] + acc[1] ) + ( acc[2] + acc[3] );
+#endif
+}
+
+// writes as many output frames as the history allows, up to max_out_frames and, if limit >= 0, no more than limit in total.
+static int _resampler_generate( apg_wav_resampler_t* rs, float* out, int max_out_frames, int64_t limit ) {
+  int n_out = 0;
+  while ( n_out < max_out_frames && rs->pos + rs->n_taps <= rs->hist_len ) {
+    if ( limit >= 0 && rs->n_out_total >= limit ) { break; }
+    float t = (float)rs->frac / (float)rs->L;
+    for ( int c = 0; c < rs->n_chans; c++ ) {
+      const float* x = &rs->hist[c * rs->hist_stride + rs->pos];
+      float y        = 0.0f;
+      switch ( rs->quality ) {
+      case APG_WAV_RESAMPLE_LINEAR: y = x[0] + ( x[1] - x[0] ) * t; break;
+      case APG_WAV_RESAMPLE_CUBIC: { // Catmull-Rom between x[1] and x[2]
+        float a = -0.5f * x[0] + 1.5f * x[1] - 1.5f * x[2] + 0.5f * x[3];
+        float b = x[0] - 2.5f * x[1] + 2.0f * x[2] - 0.5f * x[3];
+        float d = -0.5f * x[0] + 0.5f * x[2];
+        y       = ( ( a * t + b ) * t + d ) * t + x[1];
+      } break;
+      case APG_WAV_RESAMPLE_SINC: {
+        int phase = rs->n_phases == (int)rs->L ? (int)rs->frac : (int)( ( (uint64_t)rs->frac * rs->n_phases + rs->L / 2 ) / rs->L );
+        y         = _dot( &rs->coeffs[phase * rs->n_taps_padded], x, rs->n_taps_padded );
+      } break;
+      default: assert( false ); break;
+      }
+      out[n_out * rs->n_chans + c] = y;
+    }
+    n_out++;
+    rs->n_out_total++;
+    rs->frac += rs->M;
+    rs->pos += (int)( rs->frac / rs->L );
+    rs->frac %= rs->L;
+  }
+  return n_out;
+}
+
+// drops history that no future output window can reach, then appends up to n_frames. in may be NULL to append silence.
+static int _resampler_append( apg_wav_resampler_t* rs, const float* in, int n_frames ) {
+  if ( rs->pos > 0 ) {
+    int keep = rs->hist_len > rs->pos ? rs->hist_len - rs->pos : 0;
+    for ( int c = 0; c < rs->n_chans; c++ ) {
+      float* ch = &rs->hist[c * rs->hist_stride];
+      memmove( ch, &ch[rs->pos], keep * sizeof( float ) );
+    }
+    rs->pos -= rs->hist_len - keep;
+    rs->hist_len = keep;
+  }
+  int n = rs->hist_cap - rs->hist_len;
+  if ( n > n_frames ) { n = n_frames; }
+  for ( int c = 0; c < rs->n_chans; c++ ) {
+    float* dst = &rs->hist[c * rs->hist_stride + rs->hist_len];
+    if ( !in ) {
+      memset( dst, 0, n * sizeof( float ) );
+      continue;
+    }
+    for ( int i = 0; i < n; i++ ) { dst[i] = in[i * rs->n_chans + c]; }
+  }
+  rs->hist_len += n;
+  return n;
+}
+
+int apg_wav_resampler_process( apg_wav_resampler_t* rs, const float* in, int n_in_frames, float* out, int max_out_frames, int* n_in_used ) {
+  if ( n_in_used ) { *n_in_used = 0; }
+  if ( !rs || !out || n_in_frames < 0 || ( n_in_frames > 0 && !in ) || rs->flush_zeros >= 0 ) { return 0; }
+
+  int n_out = 0, n_used = 0;
+  for ( ;; ) {
+    n_out += _resampler_generate( rs, &out[n_out * rs->n_chans], max_out_frames - n_out, -1 );
+    if ( n_out >= max_out_frames || n_used >= n_in_frames ) { break; }
+    int n = _resampler_append( rs, &in[n_used * rs->n_chans], n_in_frames - n_used );
+    if ( 0 == n ) { break; }
+    n_used += n;
+  }
+  rs->n_in_total += n_used;
+  if ( n_in_used ) { *n_in_used = n_used; }
+  return n_out;
+}
+
+int apg_wav_resampler_flush( apg_wav_resampler_t* rs, float* out, int max_out_frames ) {
+  if ( !rs || !out ) { return 0; }
+  if ( rs->flush_zeros < 0 ) { rs->flush_zeros = rs->n_taps / 2; }
+  // the output covers exactly the duration of the input
+  int64_t total_out = ( rs->n_in_total * rs->L + rs->M - 1 ) / rs->M;
+
+  int n_out = 0;
+  for ( ;; ) {
+    n_out += _resampler_generate( rs, &out[n_out * rs->n_chans], max_out_frames - n_out, total_out );
+    if ( n_out >= max_out_frames || rs->n_out_total >= total_out || 0 == rs->flush_zeros ) { break; }
+    int n = _resampler_append( rs, NULL, rs->flush_zeros );
+    if ( 0 == n ) { break; }
+    rs->flush_zeros -= n;
+  }
+  return n_out;
+}
+
+// PCM <-> float [-1,1]. 8-bit wav is unsigned, wider formats are signed little-endian.
+static void _pcm_to_float( const uint8_t* src, int bits_per_sample, float* dst, int n ) {
+  switch ( bits_per_sample ) {
+  case 8:
+    for ( int i = 0; i < n; i++ ) { dst[i] = ( (int)src[i] - 128 ) * ( 1.0f / 128.0f ); }
+    break;
+  case 16:
+    for ( int i = 0; i < n; i++ ) { dst[i] = (int16_t)( src[2 * i] | src[2 * i + 1] << 8 ) * ( 1.0f / 32768.0f ); }
+    break;
+  case 24:
+    for ( int i = 0; i < n; i++ ) {
+      int32_t v = (int32_t)( (uint32_t)src[3 * i] << 8 | (uint32_t)src[3 * i + 1] << 16 | (uint32_t)src[3 * i + 2] << 24 ) >> 8;
+      dst[i]    = v * ( 1.0f / 8388608.0f );
+    }
+    break;
+  case 32:
+    for ( int i = 0; i < n; i++ ) {
+      int32_t v = (int32_t)( (uint32_t)src[4 * i] | (uint32_t)src[4 * i + 1] << 8 | (uint32_t)src[4 * i + 2] << 16 | (uint32_t)src[4 * i + 3] << 24 );
+      dst[i]    = (float)( v * ( 1.0 / 2147483648.0 ) );
+    }
+    break;
+  default: assert( false ); break;
+  }
+}
+
+static void _float_to_pcm( const float* src, int bits_per_sample, uint8_t* dst, int n ) {
+  for ( int i = 0; i < n; i++ ) {
+    double v = src[i];
+    v        = v < -1.0 ? -1.0 : v > 1.0 ? 1.0 : v;
+    switch ( bits_per_sample ) {
+    case 8: {
+      long s = lrint( v * 128.0 ) + 128;
+      dst[i] = (uint8_t)( s > 255 ? 255 : s );
+    } break;
+    case 16: {
+      long s         = lrint( v * 32768.0 );
+      s              = s > 32767 ? 32767 : s;
+      dst[2 * i]     = (uint8_t)( s & 0xFF );
+      dst[2 * i + 1] = (uint8_t)( ( s >> 8 ) & 0xFF );
+    } break;
+    case 24: {
+      long s         = lrint( v * 8388608.0 );
+      s              = s > 8388607 ? 8388607 : s;
+      dst[3 * i]     = (uint8_t)( s & 0xFF );
+      dst[3 * i + 1] = (uint8_t)( ( s >> 8 ) & 0xFF );
+      dst[3 * i + 2] = (uint8_t)( ( s >> 16 ) & 0xFF );
+    } break;
+    case 32: {
+      double d       = v * 2147483648.0;
+      uint32_t s     = (uint32_t)( d >= 2147483647.0 ? INT32_MAX : (int32_t)lrint( d ) );
+      dst[4 * i]     = (uint8_t)( s & 0xFF );
+      dst[4 * i + 1] = (uint8_t)( ( s >> 8 ) & 0xFF );
+      dst[4 * i + 2] = (uint8_t)( ( s >> 16 ) & 0xFF );
+      dst[4 * i + 3] = (uint8_t)( s >> 24 );
+    } break;
+    default: assert( false ); break;
+    }
+  }
+}
+
+// converts a whole buffer of PCM frames to a new rate, in blocks, and returns malloc'd PCM in the same format.
+static uint8_t* _resample_pcm( const uint8_t* src, int n_chans, int bits_per_sample, int n_frames, int in_rate, int out_rate,
+  apg_wav_resample_quality_t quality, int* n_frames_out, struct wav_stats_accum_t* acc ) {
+  *n_frames_out = 0;
+  if ( 8 != bits_per_sample && 16 != bits_per_sample && 24 != bits_per_sample && 32 != bits_per_sample ) { return NULL; }
+  apg_wav_resampler_t* rs = apg_wav_resampler_create( n_chans, in_rate, out_rate, quality );
+  if ( !rs ) { return NULL; }
+
+  const int bytes_per_sample = bits_per_sample / 8;
+  const int64_t total_out    = ( (int64_t)n_frames * rs->L + rs->M - 1 ) / rs->M;
+  const int max_block_out    = apg_wav_resampler_max_out_frames( rs, APG_WAV_RESAMPLE_BLOCK );
+  uint8_t* dst               = (uint8_t*)malloc( total_out > 0 ? (size_t)total_out * n_chans * bytes_per_sample : 1 );
+  float* in_block            = (float*)malloc( (size_t)APG_WAV_RESAMPLE_BLOCK * n_chans * sizeof( float ) );
+  float* out_block           = (float*)malloc( (size_t)max_block_out * n_chans * sizeof( float ) );
+  if ( !dst || !in_block || !out_block ) {
+    free( dst );
+    free( in_block );
+    free( out_block );
+    apg_wav_resampler_free( rs );
+    return NULL;
+  }
+
+  int64_t n_out = 0;
+  for ( int first = 0; first < n_frames; first += APG_WAV_RESAMPLE_BLOCK ) {
+    int n_block = n_frames - first < APG_WAV_RESAMPLE_BLOCK ? n_frames - first : APG_WAV_RESAMPLE_BLOCK;
+    const uint8_t* src_block = &src[(size_t)first * n_chans * bytes_per_sample];
+    _pcm_to_float( src_block, bits_per_sample, in_block, n_block * n_chans );
+    if ( acc ) { _stats_accum_block( acc, src_block, n_chans, n_block ); }
+    int n_used      = 0;
+    int n_block_out = apg_wav_resampler_process( rs, in_block, n_block, out_block, max_block_out, &n_used );
+    assert( n_used == n_block );
+    _float_to_pcm( out_block, bits_per_sample, &dst[(size_t)n_out * n_chans * bytes_per_sample], n_block_out * n_chans );
+    n_out += n_block_out;
+  }
+  for ( ;; ) {
+    int n_block_out = apg_wav_resampler_flush( rs, out_block, max_block_out );
+    if ( 0 == n_block_out ) { break; }
+    _float_to_pcm( out_block, bits_per_sample, &dst[(size_t)n_out * n_chans * bytes_per_sample], n_block_out * n_chans );
+    n_out += n_block_out;
+  }
+  assert( n_out == total_out );
+
+  free( in_block );
+  free( out_block );
+  apg_wav_resampler_free( rs );
+  *n_frames_out = (int)n_out;
+  return dst;
+}
+
+unsigned char* apg_read_wav_resampled( const char* filename, int out_sample_rate, apg_wav_resample_quality_t quality, int* n_chans, int* n_samples, int* bits_per_sample,
+  apg_wav_stats_t* stats ) {
+  if ( !filename || !n_chans || !n_samples || !bits_per_sample || out_sample_rate <= 0 ) { return 0; }
+  struct entire_file_t record;
+  const struct wav_fmt_subchunk_t* fmt_subchunk = NULL;
+  const uint8_t* src                            = NULL;
+  size_t data_sz                                = 0;
+  if ( !_load_wav_file( filename, &record, &fmt_subchunk, &src, &data_sz ) ) { return 0; }
+
+  int chans = fmt_subchunk->n_chans, bits = fmt_subchunk->bits_per_sample;
+  int n_in  = (int)( data_sz / ( chans * ( bits / 8 ) ) );
+  int n_out = n_in;
+  uint8_t* wav_data;
+  if ( (int)fmt_subchunk->sample_rate == out_sample_rate ) {
+    wav_data = _copy_samples( src, data_sz, chans, bits, stats );
+  } else {
+    struct wav_stats_accum_t acc;
+    _stats_accum_init( &acc, chans, bits );
+    wav_data = _resample_pcm( src, chans, bits, n_in, fmt_subchunk->sample_rate, out_sample_rate, quality, &n_out, stats ? &acc : NULL );
+    if ( wav_data && stats ) { _stats_accum_finish( &acc, stats ); }
+  }
+  free( record.data );
+  if ( !wav_data ) { return 0; }
+  *n_chans         = chans;
+  *n_samples       = n_out;
+  *bits_per_sample = bits;
   return wav_data;
 }
+
+int apg_write_wav_resampled( const char* filename, const void* data, int n_chans, int sample_rate, int n_samples, int bits_per_sample, int out_sample_rate,
+  apg_wav_resample_quality_t quality ) {
+  if ( !filename || !data || n_samples <= 0 || out_sample_rate <= 0 ) { return 0; }
+  if ( sample_rate == out_sample_rate ) { return apg_write_wav( filename, data, n_chans, sample_rate, n_samples, bits_per_sample ); }
+
+  int n_samples_out  = 0;
+  uint8_t* resampled = _resample_pcm( (const uint8_t*)data, n_chans, bits_per_sample, n_samples, sample_rate, out_sample_rate, quality, &n_samples_out, NULL );
+  if ( !resampled ) { return 0; }
+  int result = apg_write_wav( filename, resampled, n_chans, out_sample_rate, n_samples_out, bits_per_sample );
+  free( resampled );
+  return result;
+}
@@ -3,15 +3,106 @@ Wave file read/write
 Licence: see bottom of file.
 Anton Gerdelan <antonofnote at gmail>
 
+Instructions:
+- Just drop this header, and the matching .c file into your project.
+- PCM data of 8, 16, 24, or 32 bits per sample is supported. Samples are interleaved by channel.
+- n_samples always refers to samples per channel (i.e. the number of frames).
+
+Sample Rate Conversion:
+- apg_read_wav_resampled() and apg_write_wav_resampled() convert to a target sample rate once, at load/save time.
+- The apg_wav_resampler_*() functions expose the same converter for streaming blocks of interleaved float samples.
+- APG_WAV_RESAMPLE_SINC is a polyphase windowed-sinc filter with a precomputed coefficient table.
+  The inner loop uses SSE or NEON where the compiler supports it.
+- APG_WAV_RESAMPLE_LINEAR and APG_WAV_RESAMPLE_CUBIC are cheaper, lower-quality alternatives.
+
+Loudness Statistics:
+- apg_read_wav_with_stats() and apg_read_wav_resampled() can fill an apg_wav_stats_t with per-channel peak, RMS, DC offset and clip counts.
+- These are gathered in the same pass that copies or converts the samples, so normalising an imported sound needs no extra passes over it.
+  8 and 16-bit files with 1, 2, 4 or 8 channels update every channel in one SSE2 pass where the compiler supports it.
+
 Licence: see bottom of file.
 */
 
 #ifndef _APG_WAV_H_
 #define _APG_WAV_H_
 
+#ifdef __cplusplus
+extern "C" {
+#endif /* CPP */
+
+typedef enum apg_wav_resample_quality_t { APG_WAV_RESAMPLE_LINEAR, APG_WAV_RESAMPLE_CUBIC, APG_WAV_RESAMPLE_SINC } apg_wav_resample_quality_t;
+
+#define APG_WAV_STATS_MAX_CHANS 8 // statistics are gathered for at most this many channels
+
+/* Per-channel statistics of the samples as stored in the file. Values are normalised so that full scale is 1.0. */
+typedef struct apg_wav_stats_t {
+  int n_chans;                              // number of channels with statistics - the file's channel count, up to APG_WAV_STATS_MAX_CHANS
+  float peak[APG_WAV_STATS_MAX_CHANS];      // largest absolute sample value
+  float rms[APG_WAV_STATS_MAX_CHANS];       // root mean square sample value
+  float dc[APG_WAV_STATS_MAX_CHANS];        // mean sample value (DC offset)
+  int n_clipped[APG_WAV_STATS_MAX_CHANS];   // number of samples at the smallest or largest representable value
+} apg_wav_stats_t;
+
+/* Opaque streaming sample rate converter. Create with apg_wav_resampler_create(). */
+typedef struct apg_wav_resampler_t apg_wav_resampler_t;
+
+/* Writes a PCM wave file.
+RETURNS
+  * Zero on any error, non zero on success. */
 int apg_write_wav( const char* filename, const void* data, int n_chans, int sample_rate, int n_samples, int bits_per_sample );
+
+/* Reads a PCM wave file, allocates memory for the sample data, and returns it.
+RETURNS
+  * Interleaved sample data. The caller must call free() on the memory.
+  * NULL on any error. */
 unsigned char* apg_read_wav( const char* filename, int* n_chans, int* sample_rate, int* n_samples, int* bits_per_sample );
 
+/* As apg_read_wav(), but also fills stats, if not NULL, in the same pass as copying the sample data. */
+unsigned char* apg_read_wav_with_stats( const char* filename, int* n_chans, int* sample_rate, int* n_samples, int* bits_per_sample, apg_wav_stats_t* stats );
+
+/* As apg_read_wav(), but the returned data is converted to out_sample_rate, keeping the file's bits_per_sample.
+PARAMS
+  * out_sample_rate - Sample rate of the returned data e.g. 48000. If this matches the file no conversion is done.
+  * quality         - Which resampling filter to use.
+  * n_samples       - Retrieves the number of samples per channel at out_sample_rate.
+  * stats           - If not NULL, filled with statistics of the file's samples, gathered while converting them. */
+unsigned char* apg_read_wav_resampled( const char* filename, int out_sample_rate, apg_wav_resample_quality_t quality, int* n_chans, int* n_samples, int* bits_per_sample,
+  apg_wav_stats_t* stats );
+
+/* As apg_write_wav(), but data at sample_rate is converted to out_sample_rate before writing. */
+int apg_write_wav_resampled( const char* filename, const void* data, int n_chans, int sample_rate, int n_samples, int bits_per_sample, int out_sample_rate,
+  apg_wav_resample_quality_t quality );
+
+/* Creates a streaming converter from in_rate to out_rate for n_chans interleaved float channels.
+RETURNS
+  * NULL on any error. Free with apg_wav_resampler_free(). */
+apg_wav_resampler_t* apg_wav_resampler_create( int n_chans, int in_rate, int out_rate, apg_wav_resample_quality_t quality );
+
+void apg_wav_resampler_free( apg_wav_resampler_t* rs );
+
+/* Upper bound on the number of output frames that can be produced by feeding n_in_frames more input frames, plus a flush. */
+int apg_wav_resampler_max_out_frames( const apg_wav_resampler_t* rs, int n_in_frames );
+
+/* Feeds a block of interleaved float input frames and writes any output frames that are ready.
+Input is buffered internally, so blocks can be any size and need not line up with the filter length.
+PARAMS
+  * in             - n_in_frames * n_chans interleaved samples. May be NULL if n_in_frames is 0.
+  * out            - Space for max_out_frames * n_chans interleaved samples.
+  * n_in_used      - Retrieves the number of input frames consumed. If this is less than n_in_frames the output was full;
+                     call again with the remaining input and more output space.
+RETURNS
+  * The number of output frames written. */
+int apg_wav_resampler_process( apg_wav_resampler_t* rs, const float* in, int n_in_frames, float* out, int max_out_frames, int* n_in_used );
+
+/* Call after the last input block to write the final output frames still held in the filter.
+RETURNS
+  * The number of output frames written. Call again until it returns 0 if max_out_frames was too small. */
+int apg_wav_resampler_flush( apg_wav_resampler_t* rs, float* out, int max_out_frames );
+
+#ifdef __cplusplus
+}
+#endif /* CPP */
+
 #endif
 
 /*
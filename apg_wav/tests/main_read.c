@@ -1,19 +1,229 @@
 #include "apg_wav.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <math.h>
 
+#define RS_TEST_N_CHANS 2
+#define RS_TEST_MARGIN 64 // output frames skipped at each end of the error check, where the filter reads the zero padding
+
+static uint32_t _rng_state = 12345;
+static int _rand_range( int lo, int hi ) {
+  _rng_state = _rng_state * 1664525u + 1013904223u;
+  return lo + (int)( ( _rng_state >> 8 ) % (uint32_t)( hi - lo + 1 ) );
+}
+
+// two sines of different frequency and phase, amplitude 0.5, at time t seconds
+static double _ideal_signal( double t, int chan ) {
+  const double pi = 3.14159265358979323846;
+  double freq     = 0 == chan ? 1000.0 : 440.0;
+  return 0.5 * sin( 2.0 * pi * freq * t + chan );
+}
+
+// resamples a generated sine in random block sizes, checks frame counts and error against the ideal sine, and compares with apg_read_wav_resampled().
+static int _test_resampler( int in_rate, int out_rate, apg_wav_resample_quality_t quality, float max_err ) {
+  const char* quality_str = APG_WAV_RESAMPLE_LINEAR == quality ? "linear" : APG_WAV_RESAMPLE_CUBIC == quality ? "cubic" : "sinc";
+  const int n_in          = in_rate / 4;
+  const int n_expected    = (int)( ( (int64_t)n_in * out_rate + in_rate - 1 ) / in_rate );
+  int n_errors            = 0;
+
+  float* in      = (float*)malloc( sizeof( float ) * n_in * RS_TEST_N_CHANS );
+  int16_t* in_16 = (int16_t*)malloc( sizeof( int16_t ) * n_in * RS_TEST_N_CHANS );
+  for ( int i = 0; i < n_in; i++ ) {
+    for ( int c = 0; c < RS_TEST_N_CHANS; c++ ) {
+      // quantised to 16-bit so the one-shot path reading it back from a file sees the same input
+      in_16[i * RS_TEST_N_CHANS + c] = (int16_t)lrint( _ideal_signal( (double)i / in_rate, c ) * 32768.0 );
+      in[i * RS_TEST_N_CHANS + c]    = in_16[i * RS_TEST_N_CHANS + c] / 32768.0f;
+    }
+  }
+
+  // streaming, with random input block sizes and output space
+  apg_wav_resampler_t* rs = apg_wav_resampler_create( RS_TEST_N_CHANS, in_rate, out_rate, quality );
+  if ( !rs ) {
+    free( in_16 );
+    free( in );
+    return 1;
+  }
+  const int max_out = apg_wav_resampler_max_out_frames( rs, n_in );
+  float* out        = (float*)malloc( sizeof( float ) * max_out * RS_TEST_N_CHANS );
+  int n_out = 0, n_used_total = 0;
+  while ( n_used_total < n_in ) {
+    int n_block = _rand_range( 1, 3000 );
+    n_block     = n_block < n_in - n_used_total ? n_block : n_in - n_used_total;
+    int space   = _rand_range( 1, max_out - n_out );
+    int n_used  = 0;
+    n_out += apg_wav_resampler_process( rs, &in[n_used_total * RS_TEST_N_CHANS], n_block, &out[n_out * RS_TEST_N_CHANS], space, &n_used );
+    n_used_total += n_used;
+  }
+  for ( ;; ) {
+    int n = apg_wav_resampler_flush( rs, &out[n_out * RS_TEST_N_CHANS], _rand_range( 1, max_out - n_out ) );
+    if ( 0 == n ) { break; }
+    n_out += n;
+  }
+  apg_wav_resampler_free( rs );
+  if ( n_out != n_expected || n_out > max_out ) {
+    fprintf( stderr, "ERROR: %s %i->%i: %i output frames, expected %i (max %i)\n", quality_str, in_rate, out_rate, n_out, n_expected, max_out );
+    n_errors++;
+  }
+
+  // error against the ideal signal away from the ends
+  float worst = 0.0f;
+  for ( int i = RS_TEST_MARGIN; i < n_out - RS_TEST_MARGIN; i++ ) {
+    for ( int c = 0; c < RS_TEST_N_CHANS; c++ ) {
+      float err = fabsf( out[i * RS_TEST_N_CHANS + c] - (float)_ideal_signal( (double)i / out_rate, c ) );
+      worst     = err > worst ? err : worst;
+    }
+  }
+  if ( worst > max_err ) {
+    fprintf( stderr, "ERROR: %s %i->%i: max error %f exceeds %f\n", quality_str, in_rate, out_rate, worst, max_err );
+    n_errors++;
+  }
+
+  // one-shot from a file must match the streamed output, after the same conversion back to 16-bit
+  const char* tmp_filename = "test_resample.wav";
+  int chans = 0, n_samples = 0, bits = 0;
+  int16_t* oneshot = NULL;
+  if ( apg_write_wav( tmp_filename, in_16, RS_TEST_N_CHANS, in_rate, n_in, 16 ) ) {
+    oneshot = (int16_t*)apg_read_wav_resampled( tmp_filename, out_rate, quality, &chans, &n_samples, &bits, NULL );
+  }
+  remove( tmp_filename );
+  if ( !oneshot || RS_TEST_N_CHANS != chans || 16 != bits || n_samples != n_out ) {
+    fprintf( stderr, "ERROR: %s %i->%i: one-shot resample gave %i frames, streaming gave %i\n", quality_str, in_rate, out_rate, n_samples, n_out );
+    n_errors++;
+  } else {
+    for ( int i = 0; i < n_out * RS_TEST_N_CHANS; i++ ) {
+      float v = out[i] < -1.0f ? -1.0f : out[i] > 1.0f ? 1.0f : out[i];
+      long s  = lrint( v * 32768.0 );
+      s       = s > 32767 ? 32767 : s;
+      if ( oneshot[i] != s ) {
+        fprintf( stderr, "ERROR: %s %i->%i: one-shot sample %i is %i, streaming gave %li\n", quality_str, in_rate, out_rate, i, oneshot[i], s );
+        n_errors++;
+        break;
+      }
+    }
+  }
+  printf( "%s %i->%i: %i frames, max error %f\n", quality_str, in_rate, out_rate, n_out, worst );
+
+  free( oneshot );
+  free( out );
+  free( in_16 );
+  free( in );
+  return n_errors;
+}
+
+static int _check_stat( const char* name, int bits, int n_chans, int c, double got, double expected ) {
+  if ( fabs( got - expected ) <= 1e-6 + 1e-5 * fabs( expected ) ) { return 0; }
+  fprintf( stderr, "ERROR: %i-bit %i chans: chan %i %s is %f, expected %f\n", bits, n_chans, c, name, got, expected );
+  return 1;
+}
+
+// writes a synthetic file with a different DC offset, amplitude and number of clipped samples per channel, and checks the stats read back
+// against totals computed here. odd frame counts and 3 channels cover the scalar tails as well as any SIMD path.
+static int _test_stats( int bits, int n_chans, int n_frames ) {
+  const int32_t lo = 8 == bits ? -128 : 16 == bits ? -32768 : -8388608;
+  const int32_t hi = -lo - 1;
+  const int bytes  = bits / 8;
+  int n_errors     = 0;
+
+  int32_t* values = (int32_t*)malloc( sizeof( int32_t ) * n_frames * n_chans );
+  uint8_t* pcm    = (uint8_t*)malloc( (size_t)n_frames * n_chans * bytes );
+  for ( int i = 0; i < n_frames; i++ ) {
+    for ( int c = 0; c < n_chans; c++ ) {
+      int32_t dc  = ( c % 2 ? -hi : hi ) / ( 4 + c ); // alternating signs so some channels peak below zero
+      int32_t amp = hi / ( 2 + c );
+      int32_t v   = dc + _rand_range( -amp, amp );
+      if ( i < 3 + c ) { v = i % 2 ? lo : hi; } // 3 + c clipped samples per channel
+      values[i * n_chans + c] = v;
+      uint32_t u              = 8 == bits ? (uint32_t)( v + 128 ) : (uint32_t)v;
+      for ( int b = 0; b < bytes; b++ ) { pcm[( (size_t)i * n_chans + c ) * bytes + b] = (uint8_t)( u >> ( 8 * b ) ); }
+    }
+  }
+
+  const char* tmp_filename = "test_stats.wav";
+  apg_wav_stats_t stats, stats_resampled;
+  int chans = 0, rate = 0, n_samples = 0, bits_read = 0;
+  unsigned char *data = NULL, *data_resampled = NULL;
+  if ( apg_write_wav( tmp_filename, pcm, n_chans, 44100, n_frames, bits ) ) {
+    data           = apg_read_wav_with_stats( tmp_filename, &chans, &rate, &n_samples, &bits_read, &stats );
+    data_resampled = apg_read_wav_resampled( tmp_filename, 48000, APG_WAV_RESAMPLE_LINEAR, &chans, &n_samples, &bits_read, &stats_resampled );
+  }
+  remove( tmp_filename );
+  if ( !data || !data_resampled || stats.n_chans != n_chans ) {
+    fprintf( stderr, "ERROR: %i-bit %i chans: could not read stats\n", bits, n_chans );
+    n_errors++;
+  } else {
+    const double scale = 1.0 / -(double)lo;
+    for ( int c = 0; c < n_chans; c++ ) {
+      double sum = 0.0, sum_sq = 0.0, peak = 0.0;
+      int n_clipped = 0;
+      for ( int i = 0; i < n_frames; i++ ) {
+        int32_t v = values[i * n_chans + c];
+        sum += v;
+        sum_sq += (double)v * v;
+        peak = fabs( (double)v ) > peak ? fabs( (double)v ) : peak;
+        n_clipped += v == lo || v == hi;
+      }
+      if ( n_clipped != 3 + c || stats.n_clipped[c] != n_clipped || stats_resampled.n_clipped[c] != n_clipped ) {
+        fprintf( stderr, "ERROR: %i-bit %i chans: chan %i has %i clipped, expected %i\n", bits, n_chans, c, stats.n_clipped[c], n_clipped );
+        n_errors++;
+      }
+      n_errors += _check_stat( "peak", bits, n_chans, c, stats.peak[c], peak * scale );
+      n_errors += _check_stat( "rms", bits, n_chans, c, stats.rms[c], sqrt( sum_sq / n_frames ) * scale );
+      n_errors += _check_stat( "dc", bits, n_chans, c, stats.dc[c], sum / n_frames * scale );
+      n_errors += _check_stat( "resampled peak", bits, n_chans, c, stats_resampled.peak[c], stats.peak[c] );
+      n_errors += _check_stat( "resampled rms", bits, n_chans, c, stats_resampled.rms[c], stats.rms[c] );
+      n_errors += _check_stat( "resampled dc", bits, n_chans, c, stats_resampled.dc[c], stats.dc[c] );
+    }
+  }
+
+  free( data_resampled );
+  free( data );
+  free( pcm );
+  free( values );
+  return n_errors;
+}
+
 int main( int argc, char** argv ) {
+  int n_errors = 0;
+  // error bounds are a little above what each filter gives for these sines. 16-bit quantisation alone is up to 1.5e-5.
+  n_errors += _test_resampler( 44100, 48000, APG_WAV_RESAMPLE_LINEAR, 2.5e-3f );
+  n_errors += _test_resampler( 96000, 48000, APG_WAV_RESAMPLE_LINEAR, 2.5e-3f );
+  n_errors += _test_resampler( 44100, 48000, APG_WAV_RESAMPLE_CUBIC, 2e-4f );
+  n_errors += _test_resampler( 96000, 48000, APG_WAV_RESAMPLE_CUBIC, 2e-4f );
+  n_errors += _test_resampler( 44100, 48000, APG_WAV_RESAMPLE_SINC, 2e-4f );
+  n_errors += _test_resampler( 96000, 48000, APG_WAV_RESAMPLE_SINC, 2e-4f );
+  for ( int bits = 8; bits <= 24; bits += 8 ) {
+    n_errors += _test_stats( bits, 1, 5003 );
+    n_errors += _test_stats( bits, 2, 3001 );
+    n_errors += _test_stats( bits, 3, 3001 );
+    n_errors += _test_stats( bits, 8, 1031 );
+  }
+  printf( "%i errors\n", n_errors );
+  if ( n_errors ) { return 1; }
   if ( argc < 2 ) {
-    printf( "usage: ./read FILE.wav\n" );
-    return 1;
+    printf( "usage: ./read [FILE.wav [OUTPUT_SAMPLE_RATE]]\n" );
+    return 0;
   }
   int n_chans         = 0;
   int sample_rate     = 0;
   int n_samples       = 0;
   int bits_per_sample = 0;
 
-  unsigned char* wav_data = apg_read_wav( argv[1], &n_chans, &sample_rate, &n_samples, &bits_per_sample );
+  apg_wav_stats_t stats;
+  unsigned char* wav_data = apg_read_wav_with_stats( argv[1], &n_chans, &sample_rate, &n_samples, &bits_per_sample, &stats );
   if ( !wav_data ) { return 1; }
+  printf( "%s: %i chans, %iHz, %i samples, %i bits\n", argv[1], n_chans, sample_rate, n_samples, bits_per_sample );
+  for ( int c = 0; c < stats.n_chans; c++ ) {
+    printf( "  chan %i: peak %.4f, rms %.4f, dc %.4f, %i clipped\n", c, stats.peak[c], stats.rms[c], stats.dc[c], stats.n_clipped[c] );
+  }
+  free( wav_data );
+
+  if ( argc > 2 ) {
+    int out_sample_rate = atoi( argv[2] );
+    wav_data            = apg_read_wav_resampled( argv[1], out_sample_rate, APG_WAV_RESAMPLE_SINC, &n_chans, &n_samples, &bits_per_sample, NULL );
+    if ( !wav_data ) { return 1; }
+    printf( "resampled: %i chans, %iHz, %i samples, %i bits\n", n_chans, out_sample_rate, n_samples, bits_per_sample );
+    free( wav_data );
+  }
   return 0;
 }
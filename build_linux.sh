@@ -22,7 +22,7 @@ echo "building apg_console tests..."
 cd apg_console
 cp ../apg_pixfont/apg_pixfont.c ./
 cp ../apg_pixfont/apg_pixfont.h ./
-$CC $FLAGS tests/main.c apg_console.c apg_pixfont.c -I ./
+$CC $FLAGS tests/main.c apg_console.c apg_pixfont.c -I ./ -lm -pthread
 cd ..
 
 echo "building apg_interp tests..."
@@ -38,7 +38,8 @@ cd ..
 echo "building apg_pixfont tests..."
 cd apg_pixfont
 $CC $FLAGS -std=c99 -o apg_pixfont.o -I./ -c apg_pixfont.c
-$CPP $FLAGS -I./ -Itests/ tests/test_pixfont.cpp apg_pixfont.o -lm
+$CPP $FLAGS -I./ -Itests/ tests/test_pixfont.cpp apg_pixfont.o -lm -pthread
+$CC $FLAGS -I./ -I../apg/ -o bench_pixfont tests/bench_pixfont.c apg_pixfont.o -lm -pthread
 cd ..
 
 echo "building apg_tga tests..."